@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fmt/core.h>
+#include <numeric>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "bigfloat.h"
+#include "complex.h"
+#include "image.h"
+#include "isa.h"
+#include "renderer.h"
+#include "stats.h"
+#include "util.h"
+
+namespace {
+
+auto constexpr usage_str = "Usage: {} [--json FILENAME] [--runs N]\n";
+
+struct Workload {
+  std::string_view name;
+  Image::Args args;
+};
+
+// Kernel workloads are rendered at a quarter of the default resolution, as the narrow instruction
+// sets take a while on the costlier ones
+auto constexpr kernel_resolution = Image::Coord{960U, 540U};
+
+// A view of the given width around a centre given to full precision //
+[[nodiscard]] auto centered(std::string_view const re, std::string_view const im, f64 const width,
+                            n32 const maxiter) -> Image::Args {
+  auto const limbs = BigFloat::limbs_for_bits(static_cast<n32>(4 * (re.size() + im.size())));
+  auto const height = width * kernel_resolution.y / kernel_resolution.x;
+
+  return {.resolution = kernel_resolution,
+          .frame = {.lower = {-width / 2.0, -height / 2.0}, .upper = {width / 2.0, height / 2.0}},
+          .maxiter = maxiter,
+          .center = Complex{*BigFloat::parse(re, limbs), *BigFloat::parse(im, limbs)}};
+}
+
+[[nodiscard]] auto framed(Image::Frame const& frame) -> Image::Args {
+  return {.resolution = kernel_resolution, .frame = frame};
+}
+
+// Fixed views that each stress one side of the kernels //
+[[nodiscard]] auto kernel_workloads() -> std::vector<Workload> {
+  auto constexpr seahorse_re = "-0.743643887037158704752191506114774";
+  auto constexpr seahorse_im = "0.131825904205311970493132056385139";
+
+  return {
+      // Inside the period-3 minibrot, past the cardioid and bulb tests: every pixel hits
+      // maxiter unless its orbit is caught repeating, so this mostly measures how soon it is
+      {"interior", centered("-1.7549", "0", 0.002, 4096U)},
+      // Well right of the cusp, where every pixel escapes within a handful of iterations //
+      {"exterior", centered("0.5", "0", 0.2, 4096U)},
+      // Packed with boundary, where lane divergence is worst //
+      {"feigen", framed({.lower = {-1.42, -0.01125}, .upper = {-1.38, 0.01125}})},
+      {"needle", framed({.lower = {-1.80, -0.016875}, .upper = {-1.74, 0.016875}})},
+      // Deep enough for f64 lanes, then deep enough for perturbation //
+      {"deep-f64", centered(seahorse_re, seahorse_im, 1e-9, 4096U)},
+      {"deep-ptb", centered(seahorse_re, seahorse_im, 1e-20, 20000U)},
+  };
+}
+
+struct Mode {
+  std::string_view name;
+  Image::Kernel kernel;
+  bool subdivide;
+};
+
+auto constexpr modes = std::array{
+    Mode{"lockstep", Image::Kernel::Lockstep, false},
+    Mode{"refill", Image::Kernel::Refill, false},
+    Mode{"subdiv", Image::Kernel::Lockstep, true},
+};
+
+struct Result {
+  std::string_view section;
+  std::string_view view;
+  std::string_view mode;
+  Isa isa;
+  n32 threads;
+  f64 secs;
+  // Lane steps that advanced a pixel, see iterations() //
+  n64 iters;
+  Size pixels;
+  // Against the first result of the same view //
+  f64 speedup;
+
+  [[nodiscard]] auto giters() const noexcept { return static_cast<f64>(iters) / secs * 1e-9; }
+  [[nodiscard]] auto mpixels() const noexcept { return static_cast<f64>(pixels) / secs * 1e-6; }
+  // Speedup per thread against one thread, which only scaling results are measured against //
+  [[nodiscard]] auto efficiency() const noexcept -> std::optional<f64> {
+    if (section != "scaling")
+      return std::nullopt;
+    return speedup / threads;
+  }
+};
+
+// Iterations the kernels actually ran, from the workers' counters of a render of args: every lane
+// step but those that fell on lanes already done. Pixels caught by the cardioid test, retired as
+// periodic or filled in by subdivision cost none, unlike in the sum of their escape counts
+[[nodiscard]] auto iterations(Renderer& renderer, Image& img, Image::Args args) noexcept -> n64 {
+  args.stats = true;
+  renderer.render(args, img);
+
+  auto const& workers = img.stats();
+  return std::accumulate(workers.begin(), workers.end(), n64{}, [](n64 sum, WorkerStats const& w) {
+    return sum + w.lane_iterations - w.wasted_iterations;
+  });
+}
+
+// Best of runs renders, so that only the rendering itself is timed; counting iterations costs a
+// few percent of speed, so they are counted in a render of their own
+[[nodiscard]] auto measure(Renderer& renderer, Image& img, Image::Args const& args, n32 const runs)
+    -> std::pair<f64, n64> {
+  auto best = std::chrono::nanoseconds::max();
+
+  for (auto i = 0U; i < runs; ++i) {
+    auto const start = std::chrono::steady_clock::now();
+    renderer.render(args, img);
+    auto const end = std::chrono::steady_clock::now();
+
+    best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start));
+  }
+
+  return {static_cast<f64>(best.count()) * 1e-9, iterations(renderer, img, args)};
+}
+
+auto print_row(Result const& r) -> void {
+  auto const eff = r.efficiency();
+
+  fmt::print("{:<9} {:<8} {:<9} {:>7} {:>10.2f} {:>9.3f} {:>9.1f} {:>7.2f}x {:>7}\n", r.view,
+             isa_name(r.isa), r.mode, r.threads, r.secs * 1e3, r.giters(), r.mpixels(), r.speedup,
+             eff ? fmt::format("{:.0f}%", *eff * 100.0) : "-");
+}
+
+auto write_json(std::FILE* const fp, std::vector<Result> const& results) -> void {
+  fmt::print(fp, "{{\n  \"detected_isa\": \"{}\",\n  \"hardware_threads\": {},\n",
+             isa_name(detect_isa()), std::jthread::hardware_concurrency());
+  fmt::print(fp, "  \"results\": [\n");
+
+  for (auto i = Size{}; i < results.size(); ++i) {
+    auto const& r = results[i];
+    auto const eff = r.efficiency();
+
+    fmt::print(fp,
+               "    {{\"section\": \"{}\", \"view\": \"{}\", \"isa\": \"{}\", \"mode\": \"{}\", "
+               "\"threads\": {}, \"ms\": {:.3f}, \"iterations\": {}, \"pixels\": {}, "
+               "\"giter_per_s\": {:.4f}, \"mpixel_per_s\": {:.3f}, \"speedup\": {:.4f}, "
+               "\"efficiency\": {}}}{}\n",
+               r.section, r.view, isa_name(r.isa), r.mode, r.threads, r.secs * 1e3, r.iters,
+               r.pixels, r.giters(), r.mpixels(), r.speedup,
+               eff ? fmt::format("{:.4f}", *eff) : "null",
+               i + 1U == results.size() ? "" : ",");
+  }
+
+  fmt::print(fp, "  ]\n}}\n");
+}
+
+} // namespace
+
+auto main(i32 const argc, char const* const* const argv) -> int {
+  auto json = std::optional<std::string_view>{};
+  auto runs = 3U;
+
+  for (auto i = 1; i < argc; ++i) {
+    auto const arg = std::string_view{argv[i]};
+
+    if (arg == "--json" && i + 1 < argc)
+      json = argv[++i];
+    else if (arg == "--runs" && i + 1 < argc)
+      runs = std::max(static_cast<n32>(std::stoul(argv[++i])), 1U);
+    else {
+      fmt::print(usage_str, argv[0]);
+      return -1;
+    }
+  }
+
+  auto results = std::vector<Result>{};
+  auto img = Image{};
+
+  fmt::print("{:<9} {:<8} {:<9} {:>7} {:>10} {:>9} {:>9} {:>8} {:>7}\n", "view", "isa", "mode",
+             "threads", "best ms", "Giter/s", "Mpix/s", "speedup", "eff");
+
+  // The kernels on their own: one thread, every instruction set up to the widest one this CPU
+  // has, measured against SSE2 lockstep
+  {
+    auto renderer = Renderer{1U};
+
+    for (auto const& [name, args] : kernel_workloads()) {
+      auto baseline = 0.0;
+
+      for (auto isa = Isa::Sse2; isa <= detect_isa();
+           isa = static_cast<Isa>(utype_cast(isa) + 1)) {
+        for (auto const& [mname, kernel, subdivide] : modes) {
+          auto run_args = args;
+          run_args.kernel = kernel;
+          run_args.subdivide = subdivide;
+          run_args.isa = isa;
+
+          auto const [secs, iters] = measure(renderer, img, run_args, runs);
+
+          // Modes of a view differ in the iterations they run, so they are compared by time //
+          if (baseline == 0.0)
+            baseline = secs;
+
+          auto const& r = results.emplace_back(Result{
+              .section = "kernel",
+              .view = name,
+              .mode = mname,
+              .isa = img.isa(),
+              .threads = 1U,
+              .secs = secs,
+              .iters = iters,
+              .pixels = Size{args.resolution.x} * args.resolution.y,
+              .speedup = baseline / secs,
+          });
+          print_row(r);
+        }
+      }
+    }
+  }
+
+  // Full frames at the default resolution across thread counts, doubling up to the hardware's //
+  {
+    auto const args = Image::Args{};
+    auto const hardware = std::max(std::jthread::hardware_concurrency(), 1U);
+    auto baseline = 0.0;
+
+    auto counts = std::vector<n32>{};
+    for (auto threads = 1U; threads < hardware; threads *= 2U)
+      counts.push_back(threads);
+    counts.push_back(hardware);
+
+    for (auto const threads : counts) {
+      auto renderer = Renderer{threads};
+      auto const [secs, iters] = measure(renderer, img, args, runs);
+
+      if (baseline == 0.0)
+        baseline = secs;
+
+      auto const& r = results.emplace_back(Result{
+          .section = "scaling",
+          .view = "full",
+          .mode = "lockstep",
+          .isa = img.isa(),
+          .threads = threads,
+          .secs = secs,
+          .iters = iters,
+          .pixels = Size{args.resolution.x} * args.resolution.y,
+          .speedup = baseline / secs,
+      });
+      print_row(r);
+    }
+  }
+
+  if (json) {
+    auto fp = std::fopen(json->data(), "w");
+
+    if (!fp) {
+      fmt::print("Failed to write {}\n", *json);
+      return -1;
+    }
+
+    write_json(fp, results);
+
+    if (std::fclose(fp) != 0) {
+      fmt::print("Failed to write {}\n", *json);
+      return -1;
+    }
+  }
+}
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fmt/core.h>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "output.h"
+#include "shard.h"
+#include "util.h"
+
+namespace {
+
+auto constexpr usage_str = "Usage: {} [-f ascii|pgm8|pgm16|raw|png] FILENAME SHARD...\n";
+
+// Rows are read and written this many at a time, so that memory stays small at any resolution //
+auto constexpr chunk_rows = png_strip_rows;
+
+struct Shard {
+  std::string_view filename;
+  ShardHeader header;
+};
+
+// Reads the rows of the shards one after the other, as if they were a single file. Only one
+// shard is open at a time
+class RowReader {
+public:
+  explicit RowReader(std::span<Shard const> const shards) noexcept : shards_{shards} {}
+
+  RowReader(RowReader const&) = delete;
+  auto operator=(RowReader const&) -> RowReader& = delete;
+
+  ~RowReader() noexcept {
+    if (fp_)
+      std::fclose(fp_);
+  }
+
+  // Reads the next count rows into dst; returns the shard that failed to read, if one did //
+  [[nodiscard]] auto read(n32* dst, n32 count) noexcept -> Shard const* {
+    while (count != 0U) {
+      if (left_ == 0U && !open_next_())
+        return &shards_[next_ - 1U];
+
+      auto const& header = shards_[next_ - 1U].header;
+      auto const rows = std::min(count, left_);
+      auto const samples = Size{rows} * header.width;
+
+      if (std::fread(dst, sizeof(n32), samples, fp_) != samples)
+        return &shards_[next_ - 1U];
+
+      dst += samples;
+      count -= rows;
+      left_ -= rows;
+    }
+
+    return nullptr;
+  }
+
+private:
+  [[nodiscard]] auto open_next_() noexcept -> bool {
+    if (fp_)
+      std::fclose(fp_);
+
+    fp_ = std::fopen(shards_[next_++].filename.data(), "rb");
+
+    // The header was checked before, but the file may have changed since //
+    auto const header = fp_ ? read_shard_header(fp_) : std::nullopt;
+    if (!header || header->view != shards_[next_ - 1U].header.view)
+      return false;
+
+    left_ = header->rows.rows();
+    return true;
+  }
+
+  std::span<Shard const> shards_;
+  Size next_ = 0U;
+  std::FILE* fp_ = nullptr;
+  // Of the open shard //
+  n32 left_ = 0U;
+};
+
+// The shards in order, if they all belong to the same frame and hold every row of it once //
+[[nodiscard]] auto check_shards(std::vector<Shard>& shards) -> bool {
+  std::ranges::sort(shards, {}, [](Shard const& shard) { return shard.header.rows.begin; });
+
+  auto const& first = shards.front().header;
+  auto next_row = 0U;
+
+  for (auto const& [filename, header] : shards) {
+    if (header.view != first.view || header.width != first.width ||
+        header.height != first.height || header.maxiter != first.maxiter) {
+      fmt::print("{} is of another frame than {}\n", filename, shards.front().filename);
+      return false;
+    }
+
+    if (header.rows.begin != next_row) {
+      fmt::print("{} rows {} to {}\n",
+                 header.rows.begin < next_row ? "Shards overlap on" : "No shard holds",
+                 std::min(header.rows.begin, next_row), std::max(header.rows.begin, next_row));
+      return false;
+    }
+
+    next_row = header.rows.end;
+  }
+
+  if (next_row != first.height) {
+    fmt::print("No shard holds rows {} to {}\n", next_row, first.height);
+    return false;
+  }
+
+  // Kernels for other instruction sets may round some pixels differently //
+  auto const mixed = std::ranges::any_of(
+      shards, [&](Shard const& shard) { return shard.header.isa != first.isa; });
+  if (mixed)
+    fmt::print("Note: the shards were rendered with different instruction sets\n");
+
+  return true;
+}
+
+// Streams the rows of the shards into fp, chunk by chunk; returns whether every read and write
+// succeeded
+[[nodiscard]] auto merge(std::FILE* const fp, Format const format,
+                         std::span<Shard const> const shards) -> bool {
+  auto const& frame = shards.front().header;
+  auto const width = frame.width;
+  auto reader = RowReader{shards};
+
+  // PNG strips are filtered against the row above them, which is kept in front of the chunk //
+  auto buffer = std::vector<n32>(Size{chunk_rows + 1U} * width);
+  auto* const chunk = &buffer[width];
+
+  auto strips = std::vector<PngStrip>{};
+  auto ok = format == Format::Png || write_header(fp, format, width, frame.height, frame.maxiter);
+
+  for (auto y = 0U; ok && y < frame.height; y += chunk_rows) {
+    auto const rows = std::min(chunk_rows, frame.height - y);
+
+    if (auto const* const failed = reader.read(chunk, rows)) {
+      fmt::print("Failed to read {}\n", failed->filename);
+      return false;
+    }
+
+    if (format != Format::Png) {
+      ok = write_samples(fp, format, chunk, Size{rows} * width, width, frame.maxiter);
+      continue;
+    }
+
+    auto& strip = strips.emplace_back(encode_png_strip(chunk, y == 0U ? nullptr : buffer.data(),
+                                                       width, rows, frame.maxiter,
+                                                       y + rows == frame.height));
+    ok = !strip.data.empty();
+    std::copy_n(&chunk[Size{rows - 1U} * width], width, buffer.begin());
+  }
+
+  if (ok && format == Format::Png)
+    ok = write_png(fp, width, frame.height, frame.maxiter, strips);
+
+  return ok;
+}
+
+} // namespace
+
+auto main(i32 const argc, char const* const* const argv) -> int {
+  auto format = Format::Gray16;
+  auto positional = std::vector<std::string_view>{};
+
+  for (auto i = 1; i < argc; ++i) {
+    auto const arg = std::string_view{argv[i]};
+
+    if (arg == "-f" && i + 1 < argc) {
+      // Shards hold iteration counts, which only the kernels turn into colours //
+      auto const parsed = parse_format(argv[++i]);
+      if (!parsed || is_color(*parsed)) {
+        fmt::print(usage_str, argv[0]);
+        return -1;
+      }
+
+      format = *parsed;
+    } else
+      positional.push_back(arg);
+  }
+
+  if (positional.size() < 2U) {
+    fmt::print(usage_str, argv[0]);
+    return -1;
+  }
+
+  auto const start = std::chrono::high_resolution_clock::now();
+
+  auto shards = std::vector<Shard>{};
+
+  for (auto const filename : std::span{positional}.subspan(1U)) {
+    auto fp = std::fopen(filename.data(), "rb");
+    auto const header = fp ? read_shard_header(fp) : std::nullopt;
+
+    if (fp)
+      std::fclose(fp);
+
+    if (!header) {
+      fmt::print("{} is not a shard file\n", filename);
+      return -1;
+    }
+
+    shards.push_back({.filename = filename, .header = *header});
+  }
+
+  if (!check_shards(shards))
+    return -1;
+
+  auto const output = positional.front();
+  auto fp = std::fopen(output.data(), format == Format::Ascii ? "w" : "wb");
+
+  if (!fp) {
+    fmt::print("Failed to write {}\n", output);
+    return -1;
+  }
+
+  auto const ok = merge(fp, format, shards);
+
+  if ((std::fclose(fp) != 0) || !ok) {
+    fmt::print("Failed to write {}\n", output);
+    return -1;
+  }
+
+  auto const end = std::chrono::high_resolution_clock::now();
+  auto const& frame = shards.front().header;
+
+  fmt::print("Merged {} shards into a {}x{} image in {}ms\n", shards.size(), frame.width,
+             frame.height, to_ms(start, end));
+}
@@ -0,0 +1,117 @@
+#include "animation.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <string>
+#include <utility>
+
+namespace {
+
+// Splits off the next whitespace-separated word of line //
+[[nodiscard]] auto next_word(std::string_view& line) noexcept -> std::string_view {
+  auto const begin = std::min(line.find_first_not_of(" \t\r"), line.size());
+  auto const end = std::min(line.find_first_of(" \t\r", begin), line.size());
+  auto const word = line.substr(begin, end - begin);
+
+  line.remove_prefix(end);
+  return word;
+}
+
+[[nodiscard]] auto parse_n32(std::string_view const word) noexcept -> std::optional<n32> {
+  auto val = n32{};
+  auto const [end, err] = std::from_chars(word.data(), word.data() + word.size(), val);
+
+  if (err != std::errc{} || end != word.data() + word.size())
+    return std::nullopt;
+  return val;
+}
+
+[[nodiscard]] auto parse_keyframe(std::string_view line) noexcept -> std::optional<Keyframe> {
+  auto const frame = parse_n32(next_word(line));
+  auto const re = next_word(line);
+  auto const im = next_word(line);
+  auto const width = next_word(line);
+  auto const maxiter = parse_n32(next_word(line));
+
+  if (!frame || !maxiter || width.empty() || !next_word(line).empty())
+    return std::nullopt;
+
+  // Every decimal digit is worth a bit over 3 bits; the rest is headroom //
+  auto const limbs = BigFloat::limbs_for_bits(static_cast<n32>(4 * (re.size() + im.size())));
+  auto const re_big = BigFloat::parse(re, limbs);
+  auto const im_big = BigFloat::parse(im, limbs);
+  auto const width_val = std::strtod(std::string{width}.c_str(), nullptr);
+
+  if (!re_big || !im_big || !(width_val > 0.0))
+    return std::nullopt;
+
+  return Keyframe{.frame = *frame,
+                  .center = Complex{*re_big, *im_big},
+                  .width = width_val,
+                  .maxiter = std::max(*maxiter, 2U)};
+}
+
+} // namespace
+
+auto parse_keyframes(std::string_view text) noexcept -> std::optional<std::vector<Keyframe>> {
+  auto keys = std::vector<Keyframe>{};
+
+  while (!text.empty()) {
+    auto const end = std::min(text.find('\n'), text.size());
+    auto const line = text.substr(0U, end);
+    text.remove_prefix(std::min(end + 1U, text.size()));
+
+    auto const first = line.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos || line[first] == '#')
+      continue;
+
+    auto key = parse_keyframe(line);
+    if (!key || (!keys.empty() && key->frame <= keys.back().frame))
+      return std::nullopt;
+
+    keys.push_back(std::move(*key));
+  }
+
+  if (keys.empty())
+    return std::nullopt;
+
+  return keys;
+}
+
+auto zoom_args(std::span<Keyframe const> const keys, n32 const frame,
+               Image::Args const& base) noexcept -> Image::Args {
+  // The keyframes on either side, the same one twice at the ends //
+  auto const after =
+      std::ranges::find_if(keys, [&](Keyframe const& k) { return k.frame >= frame; });
+  auto const& b = after == keys.end() ? keys.back() : *after;
+  auto const& a = after == keys.begin() || after == keys.end() ? b : *(after - 1);
+
+  auto const t = a.frame == b.frame ? 0.0
+                                    : static_cast<f64>(frame - a.frame) /
+                                          static_cast<f64>(b.frame - a.frame);
+
+  auto const width = a.width * std::pow(b.width / a.width, t);
+  auto const progress = a.width == b.width ? t : (a.width - width) / (a.width - b.width);
+
+  // Centres are interpolated at the precision of the finer one //
+  auto const limbs = std::max(a.center.real.frac_limbs(), b.center.real.frac_limbs());
+  auto const widen = [&](BigFloat const& val) { return val.with_limbs(limbs); };
+  auto const step = BigFloat{progress, limbs};
+
+  auto const center =
+      Complex{widen(a.center.real) + (widen(b.center.real) - widen(a.center.real)) * step,
+              widen(a.center.imag) + (widen(b.center.imag) - widen(a.center.imag)) * step};
+
+  auto const height =
+      width * static_cast<f64>(base.resolution.y) / static_cast<f64>(base.resolution.x);
+
+  auto args = base;
+  args.center = center;
+  args.frame = {.lower = {-width / 2.0, -height / 2.0}, .upper = {width / 2.0, height / 2.0}};
+  auto const maxiter_a = static_cast<f64>(a.maxiter);
+  auto const maxiter_b = static_cast<f64>(b.maxiter);
+  args.maxiter = static_cast<n32>(std::lround(maxiter_a + (maxiter_b - maxiter_a) * progress));
+
+  return args;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "bigfloat.h"
+#include "complex.h"
+#include "image.h"
+#include "util.h"
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// A view a zoom passes through at a given frame //
+struct Keyframe {
+  n32 frame;
+  Complex<BigFloat> center;
+  f64 width;
+  n32 maxiter;
+};
+
+// Parses keyframes, one per line as FRAME RE IM WIDTH MAXITER, with blank lines and lines starting
+// with # ignored. Frames must increase from line to line; nothing is returned if they do not or a
+// line does not parse
+[[nodiscard]] auto parse_keyframes(std::string_view text) noexcept
+    -> std::optional<std::vector<Keyframe>>;
+
+// The view of a frame between the first and last keyframe, at the resolution of base and with
+// the rest of its settings. The width shrinks or grows geometrically between keyframes, so the
+// zoom runs at a steady pace, and the centre moves in step with it, so that a zoom into a point
+// keeps that point where it will end up; maxiter follows the width linearly
+[[nodiscard]] auto zoom_args(std::span<Keyframe const> keys, n32 frame,
+                             Image::Args const& base) noexcept -> Image::Args;
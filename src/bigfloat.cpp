@@ -0,0 +1,233 @@
+#include "bigfloat.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <string>
+
+BigFloat::BigFloat(f64 const val, n32 const frac_limbs) noexcept : BigFloat{frac_limbs} {
+  auto mag = std::abs(val);
+  auto whole = std::floor(mag);
+
+  limbs_.back() = static_cast<n32>(whole);
+  mag -= whole;
+
+  // Every f64 is a dyadic rational, so this is exact given enough limbs //
+  for (auto i = limbs_.size() - 1; i-- > 0 && mag != 0.0;) {
+    mag *= 4294967296.0;
+    whole = std::floor(mag);
+    limbs_[i] = static_cast<n32>(whole);
+    mag -= whole;
+  }
+
+  if (val < 0.0)
+    *this = -*this;
+}
+
+auto BigFloat::parse(std::string_view str, n32 const frac_limbs) noexcept
+    -> std::optional<BigFloat> {
+  auto const neg = !str.empty() && str.front() == '-';
+  if (!str.empty() && (str.front() == '-' || str.front() == '+'))
+    str.remove_prefix(1);
+
+  auto exponent = i32{};
+  if (auto const e = str.find_first_of("eE"); e != std::string_view::npos) {
+    auto exp_str = str.substr(e + 1);
+    auto const exp_neg = !exp_str.empty() && exp_str.front() == '-';
+    if (!exp_str.empty() && (exp_str.front() == '-' || exp_str.front() == '+'))
+      exp_str.remove_prefix(1);
+
+    if (exp_str.empty() || exp_str.size() > 6)
+      return std::nullopt;
+
+    for (auto const ch : exp_str) {
+      if (!std::isdigit(static_cast<unsigned char>(ch)))
+        return std::nullopt;
+      exponent = exponent * 10 + (ch - '0');
+    }
+
+    if (exp_neg)
+      exponent = -exponent;
+    str = str.substr(0, e);
+  }
+
+  auto const point = str.find('.');
+  auto const int_part = str.substr(0, point);
+  auto const frac_part = (point == std::string_view::npos) ? std::string_view{}
+                                                           : str.substr(point + 1);
+
+  if (int_part.empty() && frac_part.empty())
+    return std::nullopt;
+
+  // Exponent digits are moved across the point instead of multiplying afterwards, so that only
+  // genuine fractional digits ever go through the lossy division
+  auto digits = std::string{int_part};
+  digits += frac_part;
+  auto point_pos = static_cast<i64>(int_part.size()) + exponent;
+
+  if (!std::all_of(digits.cbegin(), digits.cend(),
+                   [](char ch) { return std::isdigit(static_cast<unsigned char>(ch)); }))
+    return std::nullopt;
+
+  if (point_pos < 0) {
+    digits.insert(0, static_cast<Size>(-point_pos), '0');
+    point_pos = 0;
+  } else if (point_pos > static_cast<i64>(digits.size()))
+    digits.append(static_cast<Size>(point_pos) - digits.size(), '0');
+
+  auto ret = BigFloat{frac_limbs};
+
+  for (auto i = digits.size(); i-- > static_cast<Size>(point_pos);) {
+    ret.add_small_(static_cast<n32>(digits[i] - '0'));
+    ret.div_small_(10U);
+  }
+
+  auto whole = BigFloat{frac_limbs};
+  for (auto i = Size{}; i < static_cast<Size>(point_pos); ++i) {
+    whole.mul_small_(10U);
+    whole.add_small_(static_cast<n32>(digits[i] - '0'));
+  }
+
+  ret += whole;
+
+  if (neg)
+    ret = -ret;
+
+  return ret;
+}
+
+auto BigFloat::with_limbs(n32 const frac_limbs) const noexcept -> BigFloat {
+  auto ret = BigFloat{frac_limbs};
+  auto const have = this->frac_limbs();
+
+  for (auto i = 0U; i <= std::min(have, frac_limbs); ++i)
+    ret.limbs_[frac_limbs - i] = limbs_[have - i];
+
+  // Sign-extension is unnecessary, the integer limb already carries the sign //
+  return ret;
+}
+
+auto BigFloat::to_f64() const noexcept -> f64 {
+  if (negative())
+    return -(-*this).to_f64();
+
+  auto ret = 0.0;
+  auto scale = 1.0;
+
+  for (auto i = limbs_.size(); i-- > 0 && scale != 0.0;) {
+    ret += static_cast<f64>(limbs_[i]) * scale;
+    scale /= 4294967296.0;
+  }
+
+  return ret;
+}
+
+auto BigFloat::operator+(BigFloat const& other) const noexcept -> BigFloat {
+  auto ret = *this;
+  ret += other;
+  return ret;
+}
+
+auto BigFloat::operator-(BigFloat const& other) const noexcept -> BigFloat {
+  auto ret = *this;
+  ret -= other;
+  return ret;
+}
+
+auto BigFloat::operator*(BigFloat const& other) const noexcept -> BigFloat {
+  auto ret = *this;
+  ret *= other;
+  return ret;
+}
+
+auto BigFloat::operator-() const noexcept -> BigFloat {
+  auto ret = *this;
+
+  for (auto& limb : ret.limbs_)
+    limb = ~limb;
+
+  auto carry = n64{1};
+  for (auto& limb : ret.limbs_) {
+    carry += limb;
+    limb = static_cast<n32>(carry);
+    carry >>= 32U;
+  }
+
+  return ret;
+}
+
+auto BigFloat::operator+=(BigFloat const& other) noexcept -> BigFloat& {
+  auto carry = n64{};
+
+  for (auto i = Size{}; i < limbs_.size(); ++i) {
+    carry += n64{limbs_[i]} + other.limbs_[i];
+    limbs_[i] = static_cast<n32>(carry);
+    carry >>= 32U;
+  }
+
+  return *this;
+}
+
+auto BigFloat::operator-=(BigFloat const& other) noexcept -> BigFloat& {
+  return *this += -other;
+}
+
+auto BigFloat::operator*=(BigFloat const& other) noexcept -> BigFloat& {
+  auto const neg = negative() != other.negative();
+  auto const a = negative() ? -*this : *this;
+  auto const b = other.negative() ? -other : other;
+
+  auto const n = limbs_.size();
+  auto product = std::vector<n32>(2 * n);
+
+  for (auto i = Size{}; i < n; ++i) {
+    auto carry = n64{};
+
+    for (auto j = Size{}; j < n; ++j) {
+      carry += n64{a.limbs_[i]} * b.limbs_[j] + product[i + j];
+      product[i + j] = static_cast<n32>(carry);
+      carry >>= 32U;
+    }
+
+    product[i + n] = static_cast<n32>(carry);
+  }
+
+  // Dropping the lowest frac_limbs() limbs realigns the point //
+  std::copy_n(product.cbegin() + static_cast<std::ptrdiff_t>(n - 1), n, limbs_.begin());
+
+  if (neg)
+    *this = -*this;
+
+  return *this;
+}
+
+auto BigFloat::add_small_(n32 const val) noexcept -> void {
+  auto carry = n64{val};
+
+  for (auto i = limbs_.size() - 1; carry && i < limbs_.size(); ++i) {
+    carry += limbs_[i];
+    limbs_[i] = static_cast<n32>(carry);
+    carry >>= 32U;
+  }
+}
+
+auto BigFloat::mul_small_(n32 const val) noexcept -> void {
+  auto carry = n64{};
+
+  for (auto& limb : limbs_) {
+    carry += n64{limb} * val;
+    limb = static_cast<n32>(carry);
+    carry >>= 32U;
+  }
+}
+
+auto BigFloat::div_small_(n32 const val) noexcept -> void {
+  auto rem = n64{};
+
+  for (auto i = limbs_.size(); i-- > 0;) {
+    auto const cur = (rem << 32U) | limbs_[i];
+    limbs_[i] = static_cast<n32>(cur / val);
+    rem = cur % val;
+  }
+}
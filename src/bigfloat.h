@@ -0,0 +1,56 @@
+#pragma once
+
+#include "util.h"
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Arbitrary-precision two's complement fixed-point number: one 32-bit integer limb followed by a
+// configurable number of 32-bit fractional limbs. Only meant for values of modest magnitude, such
+// as points of the complex plane near the Mandelbrot set and their reference orbits.
+class BigFloat {
+public:
+  [[nodiscard]] BigFloat() noexcept : BigFloat{0U} {}
+  [[nodiscard]] explicit BigFloat(n32 frac_limbs) noexcept : limbs_(frac_limbs + 1U) {}
+  [[nodiscard]] BigFloat(f64 val, n32 frac_limbs) noexcept;
+
+  // Parses [-]digits[.digits][e[-]digits] //
+  [[nodiscard]] static auto parse(std::string_view str, n32 frac_limbs) noexcept
+      -> std::optional<BigFloat>;
+
+  // Fractional limbs needed to hold the given number of bits after the point //
+  [[nodiscard]] static auto limbs_for_bits(n32 bits) noexcept -> n32 { return (bits + 31U) / 32U; }
+
+  [[nodiscard]] auto frac_limbs() const noexcept -> n32 {
+    return static_cast<n32>(limbs_.size()) - 1U;
+  }
+
+  // Extends with zeros or truncates to the given number of fractional limbs //
+  [[nodiscard]] auto with_limbs(n32 frac_limbs) const noexcept -> BigFloat;
+
+  // Least significant first, as stored //
+  [[nodiscard]] auto limbs() const noexcept -> std::span<n32 const> { return limbs_; }
+
+  [[nodiscard]] auto negative() const noexcept -> bool { return limbs_.back() >> 31U; }
+  [[nodiscard]] auto to_f64() const noexcept -> f64;
+
+  [[nodiscard]] auto operator+(BigFloat const& other) const noexcept -> BigFloat;
+  [[nodiscard]] auto operator-(BigFloat const& other) const noexcept -> BigFloat;
+  [[nodiscard]] auto operator*(BigFloat const& other) const noexcept -> BigFloat;
+  [[nodiscard]] auto operator-() const noexcept -> BigFloat;
+
+  auto operator+=(BigFloat const& other) noexcept -> BigFloat&;
+  auto operator-=(BigFloat const& other) noexcept -> BigFloat&;
+  auto operator*=(BigFloat const& other) noexcept -> BigFloat&;
+
+private:
+  // In-place helpers for parsing; the value must be non-negative //
+  auto add_small_(n32 val) noexcept -> void; // Adds to the integer part
+  auto mul_small_(n32 val) noexcept -> void;
+  auto div_small_(n32 val) noexcept -> void;
+
+  // Least significant limb first; the last limb is the integer part //
+  std::vector<n32> limbs_;
+};
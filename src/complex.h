@@ -10,6 +10,18 @@ template <typename T> struct Complex {
 
   auto l2sqnorm() const noexcept -> T { return real * real + imag * imag; }
 
+  [[nodiscard]] auto operator+(Complex const& other) const noexcept -> Complex {
+    return {real + other.real, imag + other.imag};
+  }
+
+  [[nodiscard]] auto operator-(Complex const& other) const noexcept -> Complex {
+    return {real - other.real, imag - other.imag};
+  }
+
+  [[nodiscard]] auto operator*(Complex const& other) const noexcept -> Complex {
+    return {real * other.real - imag * other.imag, real * other.imag + imag * other.real};
+  }
+
   [[nodiscard]] friend auto operator<<(std::ostream& os, Complex const& c) -> std::ostream& {
     return os << "Complex: {.real = " << c.real << ", .imag = " << c.imag << '}';
   }
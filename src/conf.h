@@ -1,3 +1,7 @@
 #pragma once
 
-auto constexpr inline profiling = false;
+#ifndef MANDELBROT_PROFILING
+#define MANDELBROT_PROFILING 0
+#endif
+
+auto constexpr inline profiling = MANDELBROT_PROFILING != 0;
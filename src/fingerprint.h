@@ -0,0 +1,21 @@
+#pragma once
+
+#include "util.h"
+
+#include <array>
+#include <bit>
+
+// 64-bit FNV-1a, fed a value at a time; for telling apart files, not for security //
+class Fingerprint {
+public:
+  template <typename T> auto add(T const val) noexcept -> void {
+    auto const bytes = std::bit_cast<std::array<n8, sizeof(T)>>(val);
+    for (auto const byte : bytes)
+      hash_ = (hash_ ^ byte) * 0x100000001b3U;
+  }
+
+  [[nodiscard]] auto value() const noexcept { return hash_; }
+
+private:
+  n64 hash_ = 0xcbf29ce484222325U;
+};
@@ -0,0 +1,78 @@
+#include "heatmap.h"
+#include "output.h"
+
+#include <algorithm>
+#include <fmt/core.h>
+
+Heatmap::Heatmap(n32 const width, n32 const height, n32 const lanes, n32 const maxiter) noexcept
+    : width_{(width + lanes - 1U) / lanes}, height_{height}, lanes_{lanes}, maxiter_{maxiter},
+      divergence_(Size{width_} * height_) {}
+
+auto Heatmap::add_workers(n32 const count) noexcept -> void {
+  if (workers_.size() < count)
+    workers_.resize(count);
+}
+
+auto Heatmap::measure(n32 const* const row, n32 const y, n32 const begin, n32 const end,
+                      n32 const limit) noexcept -> std::pair<n32, n32> {
+  auto* const out = &divergence_[Size{y} * width_];
+  auto widest = 0U;
+  auto saturated = 0U;
+
+  for (auto x = begin; x < end;) {
+    auto const stop = std::min((x / lanes_ + 1U) * lanes_, end);
+    auto const [lo, hi] = std::minmax_element(&row[x], &row[stop]);
+
+    for (auto i = x; i < stop; ++i)
+      saturated += row[i] >= limit ? 1U : 0U;
+
+    out[x / lanes_] = *hi - *lo;
+    widest = std::max(widest, *hi - *lo);
+    x = stop;
+  }
+
+  return {widest, saturated};
+}
+
+auto Heatmap::mirror(n32 const from, n32 const to, n32 const begin, n32 const end) noexcept
+    -> void {
+  auto const first = begin / lanes_;
+  auto const last = (end + lanes_ - 1U) / lanes_;
+
+  std::copy(&divergence_[Size{from} * width_ + first], &divergence_[Size{from} * width_ + last],
+            &divergence_[Size{to} * width_ + first]);
+}
+
+auto Heatmap::record(n32 const worker, TileCost const& cost) noexcept -> void {
+  workers_[worker].costs.push_back(cost);
+}
+
+auto Heatmap::write_divergence(std::FILE* const fp) const noexcept -> bool {
+  return write_header(fp, Format::Gray16, width_, height_, maxiter_) &&
+         write_samples(fp, Format::Gray16, divergence_.data(), divergence_.size(), width_,
+                       maxiter_);
+}
+
+auto Heatmap::write_tiles_json(std::FILE* const fp) const noexcept -> void {
+  auto tiles = std::vector<TileCost>{};
+  for (auto const& worker : workers_)
+    tiles.insert(tiles.end(), worker.costs.begin(), worker.costs.end());
+
+  std::ranges::sort(tiles, [](TileCost const& a, TileCost const& b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+
+  fmt::print(fp, "{{\n  \"lanes\": {},\n  \"maxiter\": {},\n  \"tiles\": [\n", lanes_, maxiter_);
+
+  for (auto i = Size{}; i < tiles.size(); ++i) {
+    auto const& t = tiles[i];
+
+    fmt::print(fp,
+               "    {{\"x\": {}, \"y\": {}, \"width\": {}, \"height\": {}, \"worker\": {}, "
+               "\"us\": {:.3f}, \"saturated\": {}, \"divergence\": {}}}{}\n",
+               t.x, t.y, t.width, t.height, t.worker, static_cast<f64>(t.ns) * 1e-3, t.saturated,
+               t.divergence, i + 1U == tiles.size() ? "" : ",");
+  }
+
+  fmt::print(fp, "  ]\n}}\n");
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "util.h"
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+// What one tile of a render cost //
+struct TileCost {
+  n32 x, y, width, height;
+  n32 worker;
+  // Pixels that reached the iteration limit, interior ones included //
+  n32 saturated;
+  // Largest spread of iteration counts among the lanes of a vector in the tile //
+  n32 divergence;
+  n64 ns;
+};
+
+// Where the time of a render went: the wall-clock time of every tile, and for every vector of
+// pixels the spread of their iteration counts, which is what a lockstep vector spends on lanes
+// that are already done. Vectors are taken as the aligned runs of lanes pixels of a row that the
+// lockstep kernels compute together, whichever kernel actually rendered them
+class Heatmap {
+public:
+  Heatmap(n32 width, n32 height, n32 lanes, n32 maxiter) noexcept;
+
+  // Makes room for the tiles of this many workers, keeping those already recorded //
+  auto add_workers(n32 count) noexcept -> void;
+
+  // Measures the pixels [begin, end) of row y, found at row, into the row of vectors y; returns
+  // the largest spread and how many pixels reached limit. Only one worker may measure a row
+  auto measure(n32 const* row, n32 y, n32 begin, n32 end, n32 limit) noexcept
+      -> std::pair<n32, n32>;
+
+  // Copies the measurements of [begin, end) of row from into row to, for mirrored rows //
+  auto mirror(n32 from, n32 to, n32 begin, n32 end) noexcept -> void;
+
+  // Only the given worker may record its tiles //
+  auto record(n32 worker, TileCost const& cost) noexcept -> void;
+
+  // The spreads as a 16-bit PGM, a pixel per vector //
+  [[nodiscard]] auto write_divergence(std::FILE* fp) const noexcept -> bool;
+
+  // Every tile as a JSON array, top to bottom and left to right //
+  auto write_tiles_json(std::FILE* fp) const noexcept -> void;
+
+private:
+  // Tiles one worker recorded, on cache lines of their own //
+  struct alignas(64) Tiles {
+    std::vector<TileCost> costs;
+  };
+
+  n32 width_;
+  n32 height_;
+  n32 lanes_;
+  n32 maxiter_;
+  std::vector<n32> divergence_;
+  std::vector<Tiles> workers_;
+};
@@ -1,147 +1,276 @@
 #include "image.h"
 #include "conf.h"
+#include "renderer.h"
+#include "scheduler.h"
 #include "util.h"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
-#include <fmt/compile.h>
 #include <fmt/core.h>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <thread>
 #include <vector>
 
-Image::Image(Args const& args) noexcept
-    : resolution_{args.resolution}, frame_{args.frame}, maxiter_{args.maxiter},
-      thread_count_{args.thread_count} {
+namespace {
+
+// Precision a frame needs per pixel, in units in the last place of its largest coordinate //
+auto constexpr min_ulps_per_pixel = 16.0;
+
+// Smallest pixel spacing at which perturbation deltas still fit comfortably in f32 //
+auto constexpr perturb_f32_min_spacing = 1e-30;
+
+// Error the series approximation may have, in units in the last place of the lane type //
+auto constexpr series_ulps = 1024.0;
+
+// f32 is used as long as neighbouring pixels stay well apart in its precision, then f64, then
+// perturbation around the exact centre once even f64 runs out
+[[nodiscard]] auto pick_precision(Image::Args const& args) noexcept -> Image::Precision {
+  auto const& frame = args.frame;
+
+  auto const spacing = std::min(frame.width() / static_cast<f64>(args.resolution.x),
+                                frame.height() / static_cast<f64>(args.resolution.y));
+  auto const center = args.center ? std::max(std::abs(args.center->real.to_f64()),
+                                             std::abs(args.center->imag.to_f64()))
+                                  : 0.0;
+  auto const magnitude = center + std::max({std::abs(frame.lower.x), std::abs(frame.upper.x),
+                                            std::abs(frame.lower.y), std::abs(frame.upper.y)});
+
+  auto const fits = [&]<typename T>(T) {
+    auto const ulp = magnitude * static_cast<f64>(std::numeric_limits<T>::epsilon());
+    return spacing >= ulp * min_ulps_per_pixel;
+  };
+
+  if (fits(f32{}))
+    return Image::Precision::Single;
+  else if (fits(f64{}) || !args.center)
+    return Image::Precision::Double;
+  else
+    return Image::Precision::Perturb;
+}
+
+// Rows are only mirrored when this close to being exact mirror images, a small fraction of the
+// rounding error their coordinates have anyway
+auto constexpr mirror_tolerance = 1.0 / 1024.0;
 
-  auto thread_pool = std::vector<std::jthread>{};
-  auto idx = std::atomic<n32>{};
+// The sum of the indices of rows on either side of the real axis, if the axis lies in the frame
+// on a row or halfway between two. Row y has imaginary part lower.y + y * spacing, so its mirror
+// image is row -2 * lower.y / spacing - y
+[[nodiscard]] auto find_mirror(Image::Frame const& frame, Image::Coord const& resolution) noexcept
+    -> std::optional<n32> {
+  auto const sum = -2.0 * frame.lower.y * static_cast<f64>(resolution.y) / frame.height();
+  auto const rows = std::round(sum);
 
-  for (auto i = 0U; i < thread_count_; ++i)
-    thread_pool.emplace_back(&Image::calc_, this, std::ref(idx));
+  // At least one pair of distinct rows must both fall inside the frame //
+  if (std::abs(sum - rows) > mirror_tolerance || rows < 1.0 ||
+      rows > 2.0 * static_cast<f64>(resolution.y) - 3.0)
+    return std::nullopt;
+
+  return static_cast<n32>(rows);
 }
 
-auto Image::calc_(std::atomic<n32>& idx) noexcept -> void {
-  auto const t_start = std::chrono::high_resolution_clock::now();
+} // namespace
 
-  auto constexpr block_size = 128U;
-  auto constexpr maxperiod = 350U;
+auto pick_isa(Image::Args const& args) noexcept -> Isa {
+  auto isa = std::min(args.isa, detect_isa());
 
-  auto constexpr uset_1 = IntSet{1U};
-  auto constexpr fset_4 = FloatSet{4.0F};
-  auto constexpr simd_width = static_cast<n32>(uset_1.lanes.size());
-  auto constexpr px_x_offset = []() {
-    auto ret = IntSet{0U};
-    std::iota(ret.lanes.begin(), ret.lanes.end(), 0);
-    return ret;
-  }();
+  while (isa != Isa::Sse2 && args.resolution.x % isa_width(isa) != 0)
+    isa = static_cast<Isa>(utype_cast(isa) - 1);
 
-  auto const uset_limiter = IntSet{maxiter_ - 1U};
+  return isa;
+}
 
-  auto const scaling = Complex<FloatSet>{frame_.width() / static_cast<f32>(resolution_.x),
-                                         frame_.height() / static_cast<f32>(resolution_.y)};
+Image::Image(Args const& args) noexcept { Renderer{args.thread_count}.render(args, *this); }
+
+auto Image::reset_(Args const& args) noexcept -> void {
+  resolution_ = args.resolution;
+  frame_ = args.frame;
+  maxiter_ = args.maxiter;
+  kernel_ = args.kernel;
+  precision_ = args.precision == Precision::Auto ? pick_precision(args) : args.precision;
+  subdivide_ = args.subdivide && precision_ != Precision::Perturb && !args.color;
+  interior_ = args.interior && precision_ != Precision::Perturb;
+  predict_ = args.predict && precision_ != Precision::Perturb;
+  skipped_ = 0U;
+  reused_ = 0U;
+  stats_ = args.stats;
+  color_ = args.color;
+  worker_stats_.clear();
+  isa_ = pick_isa(args);
+
+  auto const spacing = Complex{frame_.width() / static_cast<f64>(resolution_.x),
+                               frame_.height() / static_cast<f64>(resolution_.y)};
+
+  // f32 deltas are fine for perturbation until the spacing nears the bottom of their range //
+  wide_ = precision_ == Precision::Single ||
+          (precision_ == Precision::Perturb &&
+           std::min(spacing.real, spacing.imag) >= perturb_f32_min_spacing);
+
+  if (precision_ == Precision::Perturb) {
+    auto const center = args.center.value_or(
+        Complex{BigFloat{(frame_.lower.x + frame_.upper.x) / 2.0, 2U},
+                BigFloat{(frame_.lower.y + frame_.upper.y) / 2.0, 2U}});
+
+    if (!args.center)
+      frame_ = {.lower = {frame_.lower.x - center.real.to_f64(),
+                          frame_.lower.y - center.imag.to_f64()},
+                .upper = {frame_.upper.x - center.real.to_f64(),
+                          frame_.upper.y - center.imag.to_f64()}};
+
+    // Near the boundary, pixels are sensitive enough that the series must be about as accurate
+    // as the lanes that carry on from it
+    auto const tolerance =
+        series_ulps * (wide_ ? static_cast<f64>(std::numeric_limits<f32>::epsilon())
+                             : std::numeric_limits<f64>::epsilon());
+
+    reference_ = Reference::compute(center, Complex{frame_.lower.x, frame_.lower.y}, spacing,
+                                    resolution_.x, resolution_.y, maxiter_, tolerance);
+  } else {
+    reference_ = Reference{};
+
+    if (args.center) {
+      auto const offset = GenCoord<f64>{args.center->real.to_f64(), args.center->imag.to_f64()};
+      frame_ = {.lower = {frame_.lower.x + offset.x, frame_.lower.y + offset.y},
+                .upper = {frame_.upper.x + offset.x, frame_.upper.y + offset.y}};
+    }
+  }
 
-  auto period = 0U;
-  auto pxidx = n32{};
+  // Perturbed frames are off-axis by nature, so they get no mirroring //
+  axis_ = precision_ == Precision::Perturb ? std::nullopt : find_mirror(frame_, resolution_);
 
-  while ((pxidx = idx.fetch_add(simd_width * block_size, std::memory_order_relaxed)) <
-         (pixel_count_ / 2))
-    [[likely]] {
+  heatmap_.reset();
+  if (args.heatmap)
+    heatmap_.emplace(resolution_.x, resolution_.y, lanes(), maxiter_);
+}
+
+auto Image::select_(Band const band, n32* const target) noexcept -> void {
+  band_ = band;
+  pixel_count_ = Size{band.rows()} * resolution_.x;
 
-      for (auto i = 0U; i < block_size; ++i) {
-        auto const px = Complex<IntSet<n32>>{IntSet{pxidx % resolution_.x} + px_x_offset,
-                                             pxidx / resolution_.x};
+  if (!target && pixel_count_ > capacity_) {
+    data_.reset(new (img_al) n32[pixel_count_]);
+    capacity_ = pixel_count_;
+  }
 
-        auto const [c, inside] = [&] {
-          auto const px_float =
-              Complex{static_cast<FloatSet>(px.real), static_cast<FloatSet>(px.imag)};
+  pixels_ = target ? target : data_.get();
 
-          auto const _c = Complex{px_float.real * scaling.real + frame_.lower.x,
-                                  px_float.imag * scaling.imag + frame_.lower.y};
+  mirror_ = band.rows() == resolution_.y ? axis_ : std::nullopt;
 
-          auto const x = _c.real;
-          auto const y = _c.imag;
+  auto const rows = computed_rows_(band, mirror_);
+  computed_ = {.lower = {0U, rows.begin}, .upper = {resolution_.x, rows.end}};
+}
 
-          auto const a = x - 0.25F;
-          auto const b = x + 1.0F;
+auto Image::computed_rows_(Band band, std::optional<n32> const mirror) const noexcept -> Band {
+  // The computed rows are the ones on the taller side of the axis, up to and including it //
+  if (mirror && *mirror < resolution_.y)
+    band.begin = (*mirror + 1U) / 2U;
+  else if (mirror)
+    band.end = *mirror / 2U + 1U;
 
-          auto const q = a * a + y * y;
+  return band;
+}
 
-          auto const in_cardioid = q * (q + a) <= FloatSet{0.25F} * y * y;
-          auto const in_b2 = b * b + y * y <= 0.0625F;
+auto Image::work_(Scheduler& tiles, n32 const worker) noexcept -> void {
+  auto constexpr calcs =
+      std::array{&Image::calc_<Isa::Sse2>, &Image::calc_<Isa::Avx2>, &Image::calc_<Isa::Avx512>};
 
-          return std::make_pair(std::move(_c),
-                                IntSet<n32>{bit_cast<__m256i>((in_cardioid | in_b2).vec)});
-        }();
+  auto const t_start = std::chrono::high_resolution_clock::now();
 
-        auto z = c;
-        auto zsq = Complex{z.real * z.real, z.imag * z.imag};
-        auto zabssq = zsq.real + zsq.imag;
-        auto zold = zabssq;
+  if (stats_)
+    worker_stats_[worker].wake_ns += static_cast<n64>(
+        std::chrono::nanoseconds{std::chrono::steady_clock::now() - started_}.count());
 
-        auto iter = uset_limiter & inside;
-        auto done = inside | (zabssq > fset_4);
+  (this->*calcs[utype_cast(isa_)])(tiles, worker, wide_);
 
-        while (done.movemask() != -1) {
-          z.imag = (z.real + z.real) * z.imag + c.imag;
-          z.real = zsq.real - zsq.imag + c.real;
-          zsq.imag = z.imag * z.imag;
-          zsq.real = z.real * z.real;
-          zabssq = zsq.real + zsq.imag;
+  auto const t_end = std::chrono::high_resolution_clock::now();
 
-          iter += uset_1 & ~done;
-          ++period;
+  // Banded and progressive renders would print a line per band or pass and thread //
+  if constexpr (!profiling)
+    if (band_.rows() == resolution_.y && !quiet_ && !pass_.partial())
+      fmt::print("calc_(): {}ms\n", to_ms(t_start, t_end));
+}
 
-          _mm256_maskstore_epi32(reinterpret_cast<i32*>(&iter.vec),
-                                 bit_cast<__m256i>(zabssq == zold), uset_limiter.vec);
+auto Image::settle_stats_() noexcept -> void {
+  auto last = started_;
+  for (auto const& stats : worker_stats_)
+    last = std::max(last, stats.finished);
 
-          done |= (iter >= uset_limiter) | (zabssq > fset_4);
+  for (auto& stats : worker_stats_)
+    stats.idle_ns += static_cast<n64>(std::chrono::nanoseconds{last - stats.finished}.count());
+}
 
-          if (period > maxperiod) {
-            period = 0;
-            zold = zabssq;
-          }
-        }
+auto Image::fill_row_(n32 const y) noexcept -> void {
+  auto const stride = pass_.stride;
 
-        // TODO: This should calculate the location of the y-axis //
-        auto const mirror = resolution_.y - 1U - 2 * px.imag.lanes[0];
+  // Mirrored rows fill from the grid of the row they mirror, which the pass leaves untouched //
+  auto const src_y = source_row_(y);
+  auto const grid_y = src_y - (src_y - computed_.lower.y) % stride;
 
-        iter.stream_store(&data_[pxidx]);
-        iter.stream_store(&data_[pxidx + mirror * resolution_.x]);
+  auto* const dst = row_(y);
+  auto const* const src = row_(grid_y);
 
-        pxidx += simd_width;
-      }
-    }
+  // Every computed pixel stands for the run of stride pixels it starts //
+  for (auto x = 0U; x < resolution_.x; x += stride) {
+    auto const val = src[x];
+    std::fill(&dst[x + (y == grid_y ? 1U : 0U)], &dst[std::min(x + stride, resolution_.x)], val);
+  }
+}
 
-  auto const t_end = std::chrono::high_resolution_clock::now();
+auto Image::measure_tile_(Rect const& tile, n32 const worker, n64 const ns) noexcept -> void {
+  auto cost = TileCost{.x = tile.lower.x,
+                       .y = tile.lower.y,
+                       .width = tile.width(),
+                       .height = tile.height(),
+                       .worker = worker,
+                       .saturated = 0U,
+                       .divergence = 0U,
+                       .ns = ns};
+
+  for (auto y = tile.lower.y; y < tile.upper.y; ++y) {
+    auto const [divergence, saturated] =
+        heatmap_->measure(row_(y), y, tile.lower.x, tile.upper.x, maxiter_ - 1U);
+
+    cost.divergence = std::max(cost.divergence, divergence);
+    cost.saturated += saturated;
+
+    if (auto const mirror = mirror_row_(y))
+      heatmap_->mirror(y, *mirror, tile.lower.x, tile.upper.x);
+  }
 
-  if constexpr (!profiling)
-    fmt::print("calc_(): {}ms\n", to_ms(t_start, t_end));
+  heatmap_->record(worker, cost);
 }
 
 auto Image::save_pgm(std::string_view const filename) const noexcept -> bool {
-  auto fp = std::fopen(filename.data(), "w");
+  return save(filename, Format::Ascii);
+}
+
+auto Image::save(std::string_view const filename, Format const format) const noexcept -> bool {
+  auto fp = std::fopen(filename.data(), format == Format::Ascii ? "w" : "wb");
 
   if (!fp)
     return false;
 
-  // Header //
-  fmt::print(fp, "P2\n{} {} \n{} \n", resolution_.x, resolution_.y, maxiter_);
+  if (is_png(format)) {
+    auto strips = std::vector<PngStrip>{};
 
-  // Data //
-  for (auto i = 0U; i < pixel_count_; ++i) {
-    if (i % resolution_.x == 0)
-      std::putc('\n', fp);
+    for (auto y = band_.begin; y < band_.end; y += png_strip_rows)
+      strips.push_back(encode_png_strip(row_(y), y == band_.begin ? nullptr : row_(y - 1U),
+                                        resolution_.x, std::min(png_strip_rows, band_.end - y),
+                                        maxiter_, y + png_strip_rows >= band_.end, format));
 
-    auto const s = fmt::format(FMT_COMPILE("{} "), data_[i]);
-    std::fwrite(s.c_str(), sizeof(char), s.size(), fp);
+    auto const ok = write_png(fp, resolution_.x, band_.rows(), maxiter_, strips, format);
+    return (std::fclose(fp) == 0) && ok;
   }
 
-  std::fclose(fp);
-  return true;
+  auto const ok = write_header(fp, format, resolution_.x, band_.rows(), maxiter_) &&
+                  write_samples(fp, format, pixels_, pixel_count_, resolution_.x, maxiter_);
+
+  return (std::fclose(fp) == 0) && ok;
 }
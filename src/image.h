@@ -1,22 +1,32 @@
 #pragma once
 
+#include "bigfloat.h"
 #include "complex.h"
-#include "set.h"
+#include "heatmap.h"
+#include "isa.h"
+#include "output.h"
+#include "perturb.h"
+#include "stats.h"
 #include "util.h"
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string_view>
 #include <thread>
+#include <vector>
 
 auto constexpr inline img_al = std::align_val_t{64};
 
 template <typename T> struct GenCoord {
   T x, y;
-
-  [[nodiscard]] GenCoord(T x_in, T y_in) noexcept : x{x_in}, y{y_in} {}
-  [[nodiscard]] GenCoord() noexcept {}
 };
 
+class Renderer;
+class Scheduler;
+
 class Image {
 public:
   template <typename T> struct GenFrame {
@@ -27,16 +37,74 @@ public:
   };
 
   using Coord = GenCoord<n32>;
-  using PixelSet = GenCoord<IntSet<n32>>;
-  using Frame = GenFrame<f32>;
+  using Frame = GenFrame<f64>;
+  using Rect = GenFrame<n32>;
+
+  // Rows [begin, end) of the image //
+  struct Band {
+    n32 begin, end;
+
+    [[nodiscard]] auto rows() const noexcept -> n32 { return end - begin; }
+  };
+
+  // The pixels a pass of a progressive render computes: those on the grid of every stride-th
+  // pixel each way, counted from the first computed row, that the pass before it has not computed
+  // already. That pass had twice the stride, or there was none and coarser is 0
+  struct Pass {
+    n32 stride = 1U;
+    n32 coarser = 0U;
+
+    // Whether this is one pass of several rather than a render of every pixel at once //
+    [[nodiscard]] auto partial() const noexcept { return stride != 1U || coarser != 0U; }
+  };
+
+  enum class Kernel : n8 {
+    Lockstep, // Every lane of a vector iterates until the slowest one escapes
+    Refill    // Escaped lanes are refilled with the next pixel of the block
+  };
+
+  enum class Precision : n8 {
+    Auto,   // f32 unless the pixel spacing is too fine for it
+    Single, // 8 lanes of f32
+    Double, // 4 lanes of f64
+    Perturb // Deltas from a high-precision reference orbit, for zooms beyond f64
+  };
 
   struct Args {
     Coord resolution = {.x = 1920U, .y = 1080U};
-    Frame frame = {.lower = {-2.0F, -1.2F}, .upper = {1.0F, 1.2F}};
+    Frame frame = {.lower = {-2.0, -1.2}, .upper = {1.0, 1.2}};
     n32 maxiter = 4096U;
+    Kernel kernel = Kernel::Lockstep;
+    // Fills tiles whose outline has a single iteration count instead of computing them
+    // (Mariani-Silver); perturbed frames are always computed in full
+    bool subdivide = false;
+    // Tracks the derivative of every orbit and retires it as interior once that vanishes, i.e.
+    // once it has fallen into an attracting cycle; not used when perturbing
+    bool interior = false;
+    // Has every worker count what it does, see WorkerStats; costs a few percent of speed //
+    bool stats = false;
+    // Records the cost of every tile and the lane divergence of every vector, see Heatmap //
+    bool heatmap = false;
+    // Renders a small preview first to estimate what every tile costs, and deals the tiles out
+    // costliest first; not used when perturbing, as the preview would need its own reference
+    bool predict = false;
+    Precision precision = Precision::Auto;
+    // Stores every pixel as the packed RGBA colour its continuous iteration count picks from the
+    // palette (see palette.h) rather than as its count, for the colour formats. Subdivision is
+    // not used, as it compares counts; the kernels for progressive passes and reused frames do
+    // not colour, and neither does the heatmap
+    bool color = false;
+    // Exact centre of the view; when set, frame is taken relative to it //
+    std::optional<Complex<BigFloat>> center = std::nullopt;
+    // Capped to what the CPU supports and to vectors that evenly divide the rows //
+    Isa isa = detect_isa();
+    // Only used by Image(Args const&); a Renderer brings its own threads //
     n32 thread_count = std::jthread::hardware_concurrency();
   };
 
+  Image() noexcept = default;
+
+  // Renders with threads that only live for the duration of the call //
   explicit Image(Args const&) noexcept;
 
   Image(Image const&) = delete;
@@ -50,20 +118,183 @@ public:
   [[nodiscard, gnu::cold]] auto resolution() const noexcept { return resolution_; }
   [[nodiscard, gnu::cold]] auto frame() const noexcept { return frame_; }
   [[nodiscard, gnu::cold]] auto maxiter() const noexcept { return maxiter_; }
-  [[nodiscard, gnu::cold]] auto data() const noexcept { return data_.get(); }
+  [[nodiscard, gnu::cold]] auto kernel() const noexcept { return kernel_; }
+  [[nodiscard, gnu::cold]] auto precision() const noexcept { return precision_; }
+  [[nodiscard, gnu::cold]] auto isa() const noexcept { return isa_; }
+  [[nodiscard, gnu::cold]] auto subdivide() const noexcept { return subdivide_; }
+  [[nodiscard, gnu::cold]] auto skipped() const noexcept { return skipped_; }
+  // Pixels taken from the previous frame rather than computed //
+  [[nodiscard, gnu::cold]] auto reused() const noexcept { return reused_; }
+  [[nodiscard, gnu::cold]] auto interior() const noexcept { return interior_; }
+  [[nodiscard, gnu::cold]] auto color() const noexcept { return color_; }
+  // Lanes per vector of the kernels that rendered the image //
+  [[nodiscard, gnu::cold]] auto lanes() const noexcept {
+    return wide_ ? isa_width(isa_) : isa_width(isa_) / 2U;
+  }
+  // One per worker of the last render, if it was asked for stats //
+  [[nodiscard, gnu::cold]] auto stats() const noexcept {
+    return std::span<WorkerStats const>{worker_stats_};
+  }
+  // The costs of the last render, if it was asked for a heatmap //
+  [[nodiscard, gnu::cold]] auto heatmap() const noexcept -> Heatmap const* {
+    return heatmap_ ? &*heatmap_ : nullptr;
+  }
+  // The rows data() holds, which is all of them unless rendered in bands //
+  [[nodiscard, gnu::cold]] auto band() const noexcept { return band_; }
+  [[nodiscard, gnu::cold]] auto data() const noexcept { return pixels_; }
 
+  // Writes the rows held, so a band is saved as an image of its own //
+  auto save(std::string_view filename, Format format) const noexcept -> bool;
   auto save_pgm(std::string_view filename) const noexcept -> bool;
 
 private:
-  auto calc_(std::atomic<n32>& idx) noexcept -> void;
+  friend class Renderer;
+
+  // Takes on the view described by args, without touching the buffer //
+  auto reset_(Args const& args) noexcept -> void;
+
+  // Makes the buffer hold band, reallocating only if its pixels outgrow it, or renders it into
+  // target instead if one is given. Only bands covering the whole image are mirrored, as the other
+  // half of a band is usually in another one
+  auto select_(Band band, n32* target = nullptr) noexcept -> void;
+
+  // The rows of band that are computed when it is mirrored about mirror, if at all //
+  [[nodiscard]] auto computed_rows_(Band band, std::optional<n32> mirror) const noexcept -> Band;
+
+  // Start of row y, which must be in band_ //
+  [[nodiscard]] auto row_(n32 const y) const noexcept -> n32* {
+    return &pixels_[Size{y - band_.begin} * resolution_.x];
+  }
+
+  // The row holding the mirror image of row y, if it is one that is not computed //
+  [[nodiscard]] auto mirror_row_(n32 const y) const noexcept -> std::optional<n32> {
+    if (!mirror_ || y > *mirror_ || *mirror_ - y >= resolution_.y)
+      return std::nullopt;
+
+    auto const row = *mirror_ - y;
 
-  Coord resolution_;
-  Frame frame_;
-  n32 maxiter_;
+    if (row >= computed_.lower.y && row < computed_.upper.y)
+      return std::nullopt;
 
-  n32 thread_count_;
+    return row;
+  }
 
-  n32 pixel_count_ = resolution_.x * resolution_.y;
-  std::unique_ptr<n32[], void (*)(void*)> data_{new (img_al) n32[pixel_count_],
+  // The row that row y is rendered in, which is y itself unless y is mirrored //
+  [[nodiscard]] auto source_row_(n32 const y) const noexcept -> n32 {
+    return y >= computed_.lower.y && y < computed_.upper.y ? y : *mirror_ - y;
+  }
+
+  // Renders tiles until none are left; every worker of a render runs this //
+  auto work_(Scheduler& tiles, n32 worker) noexcept -> void;
+
+  // Adds to the idle time of every worker its wait for the last one to finish the render //
+  auto settle_stats_() noexcept -> void;
+
+  // Fills the pixels of row y that the pass just done left out with the nearest one it or an
+  // earlier pass computed, up and to the left, so that the image can be shown in between
+  auto fill_row_(n32 y) noexcept -> void;
+
+  // Records into the heatmap what a worker found in a tile it finished rendering in ns //
+  auto measure_tile_(Rect const& tile, n32 worker, n64 ns) noexcept -> void;
+
+  // Defined once per instruction set, each in a translation unit compiled for it //
+  template <Isa> auto calc_(Scheduler& tiles, n32 worker, bool wide) noexcept -> void;
+
+  // interior selects the kernels that also track derivatives to find interior points early, and
+  // stats those that count their work into the worker's WorkerStats, which they are then given
+  template <typename Set, bool interior, bool stats>
+  auto calc_tiles_(Scheduler& tiles, n32 worker) noexcept -> void;
+
+  // Renders every row of a tile with the kernel the image was reset to; color selects the
+  // kernels that store colours rather than counts
+  template <typename Set, bool interior, bool stats, bool color>
+  auto calc_rows_(Rect const& tile, WorkerStats* counters) noexcept -> void;
+
+  // The kernels render the pixels [begin, end) of row y //
+  template <typename Set, bool interior, bool stats, bool color = false>
+  auto calc_lockstep_(n32 y, n32 begin, n32 end, WorkerStats* counters) noexcept -> void;
+  template <typename Set, bool interior, bool stats, bool color = false>
+  auto calc_refill_(n32 y, n32 begin, n32 end, WorkerStats* counters) noexcept -> void;
+  template <typename Set, bool stats, bool color = false>
+  auto calc_perturb_(n32 y, n32 begin, n32 end, WorkerStats* counters) noexcept -> void;
+
+  // Renders the pixels of pass_ in a tile //
+  template <typename Set, bool interior, bool stats>
+  auto calc_pass_(Rect const& tile, WorkerStats* counters) noexcept -> void;
+  // Renders the pixels of a tile that cannot be taken from previous_ //
+  template <typename Set, bool interior, bool stats>
+  auto calc_reusing_(Rect const& tile, WorkerStats* counters) noexcept -> n64;
+  // Renders every step-th pixel of row y from begin up to end, in lockstep //
+  template <typename Set, bool interior, bool stats>
+  auto calc_strided_(n32 y, n32 begin, n32 end, n32 step, WorkerStats* counters) noexcept
+      -> void;
+
+  // Renders count pixels at arbitrary positions //
+  template <typename Set, bool interior, bool stats>
+  auto calc_points_(Coord const* points, n32 count, WorkerStats* counters) noexcept -> void;
+  // Render a tile or, given its computed outline, a rectangle by subdivision; both return how
+  // many pixels were filled in rather than computed
+  template <typename Set, bool interior, bool stats>
+  auto calc_outlined_(Rect const& tile, WorkerStats* counters) noexcept -> n64;
+  template <typename Set, bool interior, bool stats>
+  auto calc_subdivided_(Rect const& rect, WorkerStats* counters) noexcept -> n64;
+
+  Coord resolution_ = {};
+  Frame frame_ = {};
+  n32 maxiter_ = 0U;
+  Kernel kernel_ = Kernel::Lockstep;
+  bool subdivide_ = false;
+  bool interior_ = false;
+  bool predict_ = false;
+  bool color_ = false;
+  // Set on the renderer's own previews and the frames of a zoom, which keep their timings to
+  // themselves
+  bool quiet_ = false;
+  Precision precision_ = Precision::Auto;
+  Isa isa_ = Isa::Sse2;
+  bool wide_ = true;
+  Reference reference_;
+
+  // Rows y and *axis_ - y lie on either side of the real axis, if it is in the frame //
+  std::optional<n32> axis_;
+  // axis_ if the rows are mirrored, in which case only the ones in computed_ are rendered and the
+  // others copied from them
+  std::optional<n32> mirror_;
+  Rect computed_ = {};
+
+  // The pixels the render computes, of the whole image unless it is progressive //
+  Pass pass_ = {};
+
+  // Pixels filled in by subdivision rather than computed //
+  n64 skipped_ = 0U;
+
+  // The frame before this one, which pixels within reuse_tolerance_ of one of its own, in its
+  // pixels, are taken from, if the render is reusing one
+  Image const* previous_ = nullptr;
+  f64 reuse_tolerance_ = 0.0;
+  n64 reused_ = 0U;
+
+  bool stats_ = false;
+  std::vector<WorkerStats> worker_stats_;
+  std::chrono::steady_clock::time_point started_;
+  std::optional<Heatmap> heatmap_;
+
+  Band band_ = {};
+  Size pixel_count_ = 0U;
+  Size capacity_ = 0U;
+  std::unique_ptr<n32[], void (*)(void*)> data_{nullptr,
                                                 [](void* p) { operator delete[](p, img_al); }};
+  // The band's pixels, in data_ unless rendered into a target owned by the caller //
+  n32* pixels_ = nullptr;
 };
+
+// The widest instruction set both asked for and supported whose vectors evenly divide the rows,
+// the one an image rendered with args uses
+[[nodiscard]] auto pick_isa(Image::Args const& args) noexcept -> Isa;
+
+template <>
+auto Image::calc_<Isa::Sse2>(Scheduler& tiles, n32 worker, bool wide) noexcept -> void;
+template <>
+auto Image::calc_<Isa::Avx2>(Scheduler& tiles, n32 worker, bool wide) noexcept -> void;
+template <>
+auto Image::calc_<Isa::Avx512>(Scheduler& tiles, n32 worker, bool wide) noexcept -> void;
@@ -0,0 +1,40 @@
+#include "isa.h"
+
+auto detect_isa() noexcept -> Isa {
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+      __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") &&
+      __builtin_cpu_supports("avx512cd"))
+    return Isa::Avx512;
+
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+      __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2"))
+    return Isa::Avx2;
+
+  return Isa::Sse2;
+}
+
+auto parse_isa(std::string_view const name) noexcept -> std::optional<Isa> {
+  if (name == "sse2")
+    return Isa::Sse2;
+  if (name == "avx2")
+    return Isa::Avx2;
+  if (name == "avx512")
+    return Isa::Avx512;
+
+  return std::nullopt;
+}
+
+auto isa_name(Isa const isa) noexcept -> std::string_view {
+  switch (isa) {
+  case Isa::Sse2:
+    return "sse2";
+  case Isa::Avx2:
+    return "avx2";
+  case Isa::Avx512:
+    return "avx512";
+  }
+
+  return "unknown";
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "util.h"
+
+#include <optional>
+#include <string_view>
+
+// SIMD instruction sets the kernels are built for, narrowest first //
+enum class Isa : n8 {
+  Sse2,  // x86-64 baseline, 4 f32 lanes
+  Avx2,  // x86-64-v3, 8 f32 lanes
+  Avx512 // x86-64-v4, 16 f32 lanes with mask registers
+};
+
+// Widest instruction set the running CPU supports //
+[[nodiscard]] auto detect_isa() noexcept -> Isa;
+
+[[nodiscard]] auto parse_isa(std::string_view name) noexcept -> std::optional<Isa>;
+[[nodiscard]] auto isa_name(Isa isa) noexcept -> std::string_view;
+
+// f32 lanes per vector, which rows must be a multiple of //
+[[nodiscard]] auto constexpr inline isa_width(Isa const isa) noexcept -> n32 {
+  return 4U << utype_cast(isa);
+}
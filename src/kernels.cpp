@@ -0,0 +1,914 @@
+// Compiled once per instruction set (see CMakeLists.txt); everything here is either a member of
+// Image instantiated with that set's types or internal to the translation unit
+#include "image.h"
+#include "palette.h"
+#include "scheduler.h"
+#include "set.h"
+#include "util.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+using namespace simd::native;
+
+auto constexpr maxperiod = 350U;
+auto constexpr interior_distsq = 1e-12;
+auto constexpr interior_dzsq = 0.25;
+
+template <typename Set> using IntOf = typename Set::Int;
+template <typename Set> using MaskOf = typename Set::Mask;
+template <typename Set> using ScalarOf = typename Set::Scalar;
+
+template <typename Set> auto constexpr all_lanes = (1U << Set::width) - 1U;
+
+template <typename Set> auto constexpr px_x_offset = []() {
+  auto ret = IntOf<Set>{};
+  std::iota(ret.lanes.begin(), ret.lanes.end(), 0U);
+  return ret;
+}();
+
+// Writes one vector of iteration counts to consecutive pixels //
+auto stream_store_iters(IntSet<n32> const& iter, n32* const out) noexcept -> void {
+  iter.stream_store(out);
+}
+
+auto stream_store_iters(IntSet<n64> const& iter, n32* const out) noexcept -> void {
+  iter.stream_store_narrow(out);
+}
+
+// Lanes truncated towards zero to the integers of the same width //
+template <typename Set> [[nodiscard]] auto truncate(Set const& val) noexcept -> IntOf<Set> {
+  using Signed = IntSet<std::make_signed_t<typename IntOf<Set>::Scalar>>;
+  return IntOf<Set>{static_cast<Signed>(val).vec};
+}
+
+// How far past the escape an orbit that left with |z|^2 = zabssq got in its last step, as a
+// fraction of a step: log2(log2(zabssq) / 2), which runs from 0 to 1 as zabssq runs from 4 to 16.
+// It is taken from a polynomial in (zabssq - 10) / 6, within 0.0025 of it, as the sets have no
+// logarithm; the rare orbits that jump past 16 are taken to have gone a whole step
+template <typename Set> [[nodiscard]] auto escape_fraction(Set const& zabssq) noexcept -> Set {
+  auto constexpr fset_4 = Set{4.0F};
+  auto constexpr fset_16 = Set{16.0F};
+
+  auto const clamped = zabssq.blend(fset_4, zabssq < fset_4).blend(fset_16, zabssq > fset_16);
+  auto const x = (clamped - Set{10.0F}) * Set{1.0F / 6.0F};
+
+  auto poly = Set{0.0494848056F};
+  poly = poly * x + Set{-0.0841716916F};
+  poly = poly * x + Set{0.0731106675F};
+  poly = poly * x + Set{-0.145435768F};
+  poly = poly * x + Set{0.376494359F};
+  return poly * x + Set{0.731094865F};
+}
+
+// Colours of the lanes from their iteration counts and |z|^2 as they escaped: the continuous
+// count, iter + 1 - escape_fraction(), normalised by scale to an entry of the palette. Lanes that
+// reached the limit, the interior, are black
+template <typename Set>
+[[nodiscard]] auto colorize(IntOf<Set> const& iter, Set const& zabssq,
+                            IntOf<Set> const& uset_limiter, Set const& scale) noexcept
+    -> IntOf<Set> {
+  using Int = IntOf<Set>;
+  using Lane = typename Int::Scalar;
+
+  auto const interior = iter >= uset_limiter;
+  auto const smooth = static_cast<Set>(iter) + Set{1.0F} - escape_fraction(zabssq);
+
+  // The palette ends in the colour it starts with, so entries wrap around it; that way the
+  // lanes of the interior, and any that hold no pixel, look up an entry in it as well
+  static_assert(std::has_single_bit(palette_size));
+  auto const idx = truncate(smooth * scale) & Int{Lane{palette_size - 1U}};
+
+  return Int::gather(palette<Lane>(), idx).blend(Int{Lane{interior_rgba}}, interior);
+}
+
+// Normalises continuous counts below maxiter to the entries of the palette //
+template <typename Set> [[nodiscard]] auto palette_scale(n32 const maxiter) noexcept -> Set {
+  auto const scale = static_cast<f64>(palette_size) / static_cast<f64>(maxiter);
+  return Set{static_cast<ScalarOf<Set>>(scale)};
+}
+
+template <typename Set>
+[[nodiscard]] auto pixel_scaling(Image::Frame const& frame, Image::Coord const& resolution) noexcept
+    -> Complex<Set> {
+  using Scalar = ScalarOf<Set>;
+  return {Set{static_cast<Scalar>(frame.width() / static_cast<f64>(resolution.x))},
+          Set{static_cast<Scalar>(frame.height() / static_cast<f64>(resolution.y))}};
+}
+
+// Maps pixel coordinates to points of the complex plane, flagging those that lie inside the main
+// cardioid or the period-2 bulb and so never escape
+template <typename Set>
+[[nodiscard]] auto map_pixels(Complex<IntOf<Set>> const& px, Complex<Set> const& scaling,
+                              Image::Frame const& frame) noexcept
+    -> std::pair<Complex<Set>, MaskOf<Set>> {
+  using Scalar = ScalarOf<Set>;
+
+  auto const px_float = Complex{static_cast<Set>(px.real), static_cast<Set>(px.imag)};
+
+  auto const c = Complex{px_float.real * scaling.real + static_cast<Scalar>(frame.lower.x),
+                         px_float.imag * scaling.imag + static_cast<Scalar>(frame.lower.y)};
+
+  auto const x = c.real;
+  auto const y = c.imag;
+
+  auto const a = x - 0.25F;
+  auto const b = x + 1.0F;
+
+  auto const q = a * a + y * y;
+
+  auto const in_cardioid = q * (q + a) <= Set{0.25F} * y * y;
+  auto const in_b2 = b * b + y * y <= 0.0625F;
+
+  return std::make_pair(c, in_cardioid | in_b2);
+}
+
+// Rectangles whose inside is this small are cheaper to compute than to split further //
+auto constexpr min_split_pixels = 64U;
+
+// Pixels gathered for calc_points_: an outline of a subdivision tile or the inside of a rectangle
+// too small to split
+class Points {
+public:
+  auto push(Image::Coord const& point) noexcept -> void { points_[size_++] = point; }
+
+  [[nodiscard]] auto data() const noexcept { return points_.data(); }
+  [[nodiscard]] auto size() const noexcept { return size_; }
+
+private:
+  std::array<Image::Coord, std::max(min_split_pixels, 2U * (Scheduler::subdivision_tile_size.x +
+                                                            Scheduler::subdivision_tile_size.y))>
+      points_;
+  n32 size_ = 0U;
+};
+
+// Derivative of z with respect to the point its orbit was last saved at, one step further along
+// it. Lanes that are done get 0, or their derivatives would keep shrinking into denormals, which
+// are very slow
+template <typename Set>
+[[nodiscard]] auto derive(Complex<Set> const& z, Complex<Set> const& dz,
+                          MaskOf<Set> const& done) noexcept -> Complex<Set> {
+  auto const next = Complex{z.real + z.real, z.imag + z.imag} * dz;
+  return Complex{next.real & ~done, next.imag & ~done};
+}
+
+// Orbits that have come back to the point they were saved at, so have gone round a cycle one or
+// more times since, and whose derivative over those rounds has shrunk, so the cycle attracts them.
+// Lanes are saved after stretches of steps that double every time, as in Brent's cycle detection,
+// so a cycle of any period is soon gone round within one. The derivative alone says nothing: an
+// escaping orbit that creeps past a cusp or bulb root shrinks it on the way in, but only comes
+// back this close where it is near 1, hence the margin. Attracting cycles that shrink it less are
+// left to the other checks
+template <typename Set>
+[[nodiscard]] auto attracted(Complex<Set> const& z, Complex<Set> const& saved,
+                             Complex<Set> const& dz) noexcept -> MaskOf<Set> {
+  using Scalar = ScalarOf<Set>;
+  return ((z - saved).l2sqnorm() < Set{static_cast<Scalar>(interior_distsq)}) &
+         (dz.l2sqnorm() < Set{static_cast<Scalar>(interior_dzsq)});
+}
+
+// Saves z for the lanes whose stretch is up after one more step, starting their derivatives over
+// and doubling their stretches, see attracted()
+template <typename Set>
+auto checkpoint(Complex<Set> const& z, Complex<Set>& saved, Complex<Set>& dz, IntOf<Set>& since,
+                IntOf<Set>& stretch) noexcept -> void {
+  using Int = IntOf<Set>;
+
+  since += Int{1U};
+  auto const due = since >= stretch;
+
+  saved = Complex{saved.real.blend(z.real, due), saved.imag.blend(z.imag, due)};
+  dz = Complex{dz.real.blend(Set{1.0F}, due), dz.imag.blend(Set{}, due)};
+  since = since.blend(Int{}, due);
+  stretch = stretch.blend(stretch + stretch, due);
+}
+
+// Lanes set in a mask //
+template <typename Mask> [[nodiscard]] auto count_lanes(Mask const& mask) noexcept -> n64 {
+  return static_cast<n64>(std::popcount(mask.bits()));
+}
+
+// Counts one step of a vector whose lanes in done sat it out //
+template <typename Set>
+auto count_step(MaskOf<Set> const& done, WorkerStats* const counters) noexcept -> void {
+  counters->lane_iterations += Set::width;
+  counters->wasted_iterations += count_lanes(done);
+}
+
+// Iterates c until every lane has escaped, turned out to be periodic or reached the limit. The
+// period counter carries over between calls, like the lanes of a long row would. With color,
+// the |z|^2 of every lane as it was done goes to escaped
+template <bool interior, bool stats, bool color = false, typename Set>
+[[nodiscard]] auto iterate_lockstep(Complex<Set> const& c, MaskOf<Set> const& inside,
+                                    IntOf<Set> const& uset_limiter, n32& period,
+                                    WorkerStats* const counters,
+                                    Set* const escaped = nullptr) noexcept -> IntOf<Set> {
+  using Int = IntOf<Set>;
+
+  auto constexpr uset_1 = Int{1U};
+  auto constexpr fset_4 = Set{4.0F};
+
+  auto z = c;
+  auto zsq = Complex{z.real * z.real, z.imag * z.imag};
+  auto zabssq = zsq.real + zsq.imag;
+  auto zold = zabssq;
+  auto saved = z;
+  auto dz = Complex{Set{1.0F}, Set{}};
+  auto since = Int{};
+  auto stretch = uset_1;
+
+  auto iter = uset_limiter & inside;
+  auto done = inside | (zabssq > fset_4);
+  auto last = zabssq;
+
+  if constexpr (stats) {
+    ++counters->vectors;
+    counters->cardioid_exits += count_lanes(inside);
+  }
+
+  while (!done.all()) {
+    if constexpr (stats)
+      count_step<Set>(done, counters);
+
+    if constexpr (interior)
+      dz = derive(z, dz, done);
+
+    z.imag = (z.real + z.real) * z.imag + c.imag;
+    z.real = zsq.real - zsq.imag + c.real;
+    zsq.imag = z.imag * z.imag;
+    zsq.real = z.real * z.real;
+    zabssq = zsq.real + zsq.imag;
+
+    iter += uset_1 & ~done;
+    ++period;
+
+    auto periodic = zabssq == zold;
+    if constexpr (interior) {
+      periodic |= attracted(z, saved, dz);
+      checkpoint(z, saved, dz, since, stretch);
+    }
+
+    if constexpr (stats)
+      counters->periodic_exits += count_lanes(periodic & ~done);
+
+    iter = iter.blend(uset_limiter, periodic & ~done);
+
+    // Lanes that are done carry on iterating, so only the step that finishes them counts //
+    if constexpr (color)
+      last = last.blend(zabssq, ~done);
+
+    done |= (iter >= uset_limiter) | (zabssq > fset_4);
+
+    if (period > maxperiod) {
+      period = 0;
+      zold = zabssq;
+    }
+  }
+
+  if constexpr (color)
+    *escaped = last;
+
+  return iter;
+}
+
+} // namespace
+
+template <>
+auto Image::calc_<simd::native_isa>(Scheduler& tiles, n32 const worker, bool const wide) noexcept
+    -> void {
+  auto const calc = [&](auto const stats) {
+    if (wide && interior_)
+      calc_tiles_<FloatSet, true, stats>(tiles, worker);
+    else if (wide)
+      calc_tiles_<FloatSet, false, stats>(tiles, worker);
+    else if (interior_)
+      calc_tiles_<DoubleSet, true, stats>(tiles, worker);
+    else
+      calc_tiles_<DoubleSet, false, stats>(tiles, worker);
+  };
+
+  if (stats_)
+    calc(std::true_type{});
+  else
+    calc(std::false_type{});
+}
+
+template <typename Set, bool interior, bool stats>
+auto Image::calc_tiles_(Scheduler& tiles, n32 const worker) noexcept -> void {
+  using Clock = std::chrono::steady_clock;
+
+  auto* const counters = stats ? &worker_stats_[worker] : nullptr;
+  auto skipped = n64{};
+  auto reused = n64{};
+  auto last = stats ? Clock::now() : Clock::time_point{};
+
+  // Charges the time since the last call to the given counter //
+  auto const lap = [&](n64& ns) {
+    auto const now = Clock::now();
+    ns += static_cast<n64>(std::chrono::nanoseconds{now - last}.count());
+    last = now;
+  };
+
+  while (auto const tile = tiles.next(worker)) {
+    if constexpr (stats) {
+      lap(counters->schedule_ns);
+      ++counters->tiles;
+    }
+
+    auto const tile_start = heatmap_ ? Clock::now() : Clock::time_point{};
+
+    if (previous_)
+      reused += calc_reusing_<Set, interior, stats>(*tile, counters);
+    else if (pass_.partial())
+      calc_pass_<Set, interior, stats>(*tile, counters);
+    else if (subdivide_)
+      skipped += calc_outlined_<Set, interior, stats>(*tile, counters);
+    else if (color_)
+      calc_rows_<Set, interior, stats, true>(*tile, counters);
+    else
+      calc_rows_<Set, interior, stats, false>(*tile, counters);
+
+    if (heatmap_) [[unlikely]]
+      measure_tile_(*tile, worker,
+                    static_cast<n64>(std::chrono::nanoseconds{Clock::now() - tile_start}.count()));
+
+    tiles.done(*tile);
+
+    if constexpr (stats)
+      lap(counters->busy_ns);
+  }
+
+  if constexpr (stats) {
+    lap(counters->schedule_ns);
+    counters->finished = last;
+  }
+
+  if (skipped)
+    std::atomic_ref{skipped_}.fetch_add(skipped, std::memory_order_relaxed);
+
+  if (reused)
+    std::atomic_ref{reused_}.fetch_add(reused, std::memory_order_relaxed);
+}
+
+template <typename Set, bool interior, bool stats, bool color>
+auto Image::calc_rows_(Rect const& tile, WorkerStats* const counters) noexcept -> void {
+  for (auto y = tile.lower.y; y < tile.upper.y; ++y) {
+    if (precision_ == Precision::Perturb)
+      calc_perturb_<Set, stats, color>(y, tile.lower.x, tile.upper.x, counters);
+    else if (kernel_ == Kernel::Refill)
+      calc_refill_<Set, interior, stats, color>(y, tile.lower.x, tile.upper.x, counters);
+    else
+      calc_lockstep_<Set, interior, stats, color>(y, tile.lower.x, tile.upper.x, counters);
+  }
+}
+
+template <typename Set, bool interior, bool stats, bool color>
+auto Image::calc_lockstep_(n32 const y, n32 const begin, n32 const end,
+                           WorkerStats* const counters) noexcept -> void {
+  using Int = IntOf<Set>;
+  using Lane = typename Int::Scalar;
+
+  auto const uset_limiter = Int{Lane{maxiter_ - 1U}};
+  auto const scaling = pixel_scaling<Set>(frame_, resolution_);
+  auto const scale = palette_scale<Set>(maxiter_);
+
+  auto* const row = row_(y);
+  auto const mirror_y = mirror_row_(y);
+  auto* const mirror = mirror_y ? row_(*mirror_y) : nullptr;
+
+  auto period = 0U;
+
+  for (auto x = begin; x < end; x += Set::width) {
+    auto const px = Complex<Int>{Int{Lane{x}} + px_x_offset<Set>, Int{Lane{y}}};
+
+    auto const [c, inside] = map_pixels(px, scaling, frame_);
+
+    auto escaped = Set{};
+    auto iter = iterate_lockstep<interior, stats, color>(c, inside, uset_limiter, period,
+                                                         counters, &escaped);
+
+    // Colours go straight from the lanes to the image, never stored as counts first //
+    if constexpr (color)
+      iter = colorize(iter, escaped, uset_limiter, scale);
+
+    stream_store_iters(iter, &row[x]);
+
+    if (mirror)
+      stream_store_iters(iter, &mirror[x]);
+  }
+}
+
+template <typename Set, bool interior, bool stats, bool color>
+auto Image::calc_refill_(n32 const y, n32 const begin, n32 const end,
+                         WorkerStats* const counters) noexcept -> void {
+  using Int = IntOf<Set>;
+  using Mask = MaskOf<Set>;
+  using Lane = typename Int::Scalar;
+
+  auto constexpr uset_1 = Int{1U};
+  auto constexpr fset_4 = Set{4.0F};
+
+  auto const uset_limiter = Int{Lane{maxiter_ - 1U}};
+  auto const scaling = pixel_scaling<Set>(frame_, resolution_);
+  auto const scale = palette_scale<Set>(maxiter_);
+
+  // Lanes only ever take pixels from the same row, so refills can be done entirely in-register //
+  auto* const row = row_(y);
+  auto const mirror_y = mirror_row_(y);
+  auto* const mirror = mirror_y ? row_(*mirror_y) : nullptr;
+
+  auto const uset_row_end = Int{Lane{end}};
+
+  auto next = begin;
+  auto retired = 0U;
+  auto period = 0U;
+
+  auto px = Complex<Int>{Int{}, Int{Lane{y}}};
+
+  auto c = Complex<Set>{};
+  auto z = Complex<Set>{};
+  auto zsq = Complex<Set>{};
+  auto zabssq = Set{};
+  auto zold = Set{};
+  auto saved = Complex<Set>{};
+  auto dz = Complex<Set>{};
+  auto since = Int{};
+  auto stretch = Int{};
+  auto iter = Int{};
+  auto done = ~Mask{};
+
+  // Hands the next pixels of the row to the given lanes, retiring those that find none left //
+  auto const load = [&](n32 const lanes) {
+    auto const wanted = Mask::from_bits(lanes);
+    auto const candidate = Int{Lane{next}} + Int::rank(wanted);
+    auto const fresh = wanted & (candidate < uset_row_end);
+
+    next += static_cast<n32>(std::popcount(lanes));
+    retired |= lanes & ~fresh.bits();
+
+    px.real = px.real.blend(candidate, fresh);
+
+    auto const [c_new, inside] = map_pixels(px, scaling, frame_);
+    auto const zsq_new = Complex{c_new.real * c_new.real, c_new.imag * c_new.imag};
+    auto const zabssq_new = zsq_new.real + zsq_new.imag;
+
+    c = Complex{c.real.blend(c_new.real, fresh), c.imag.blend(c_new.imag, fresh)};
+    z = Complex{z.real.blend(c_new.real, fresh), z.imag.blend(c_new.imag, fresh)};
+    zsq = Complex{zsq.real.blend(zsq_new.real, fresh), zsq.imag.blend(zsq_new.imag, fresh)};
+    zabssq = zabssq.blend(zabssq_new, fresh);
+    zold = zold.blend(zabssq_new, fresh);
+    saved = Complex{saved.real.blend(c_new.real, fresh), saved.imag.blend(c_new.imag, fresh)};
+    dz = Complex{dz.real.blend(Set{1.0F}, fresh), dz.imag.blend(Set{}, fresh)};
+    since = since.blend(Int{}, fresh);
+    stretch = stretch.blend(uset_1, fresh);
+    iter = iter.blend(uset_limiter & inside, fresh);
+    done = done.blend((zabssq_new > fset_4) | inside, fresh) | Mask::from_bits(retired);
+
+    if constexpr (stats) {
+      ++counters->vectors;
+      counters->cardioid_exits += count_lanes(inside & fresh);
+    }
+  };
+
+  load(all_lanes<Set>);
+
+  while (retired != all_lanes<Set>) {
+    if (auto const finished = done.bits() & ~retired; finished) {
+      // Finished lanes are refilled before they step again, so zabssq is still theirs //
+      auto vals = iter;
+      if constexpr (color)
+        vals = colorize(iter, zabssq, uset_limiter, scale);
+
+      for (auto i = 0U; i < Set::width; ++i) {
+        if (!(finished & (1U << i)))
+          continue;
+
+        auto const x = static_cast<n32>(px.real.lanes[i]);
+        auto const val = static_cast<n32>(vals.lanes[i]);
+
+        row[x] = val;
+
+        if (mirror)
+          mirror[x] = val;
+      }
+
+      load(finished);
+      continue;
+    }
+
+    if constexpr (stats)
+      count_step<Set>(done, counters);
+
+    if constexpr (interior)
+      dz = derive(z, dz, done);
+
+    z.imag = (z.real + z.real) * z.imag + c.imag;
+    z.real = zsq.real - zsq.imag + c.real;
+    zsq.imag = z.imag * z.imag;
+    zsq.real = z.real * z.real;
+    zabssq = zsq.real + zsq.imag;
+
+    iter += uset_1 & ~done;
+    ++period;
+
+    auto periodic = zabssq == zold;
+    if constexpr (interior) {
+      periodic |= attracted(z, saved, dz);
+      checkpoint(z, saved, dz, since, stretch);
+    }
+
+    if constexpr (stats)
+      counters->periodic_exits += count_lanes(periodic & ~done);
+
+    iter = iter.blend(uset_limiter, periodic & ~done);
+
+    done |= (iter >= uset_limiter) | (zabssq > fset_4);
+
+    if (period > maxperiod) {
+      period = 0;
+      zold = zabssq;
+    }
+  }
+}
+
+template <typename Set, bool stats, bool color>
+auto Image::calc_perturb_(n32 const y, n32 const begin, n32 const end,
+                          WorkerStats* const counters) noexcept -> void {
+  using Int = IntOf<Set>;
+  using Lane = typename Int::Scalar;
+  using Scalar = ScalarOf<Set>;
+
+  auto constexpr uset_0 = Int{};
+  auto constexpr uset_1 = Int{1U};
+  auto constexpr fset_4 = Set{4.0F};
+
+  auto const* const orbit_re = reference_.orbit_re<Scalar>().data();
+  auto const* const orbit_im = reference_.orbit_im<Scalar>().data();
+
+  auto const uset_limiter = Int{Lane{maxiter_ - 1U}};
+  auto const uset_last = Int{Lane{reference_.length() - 1U}};
+  auto const uset_skip = Int{Lane{reference_.skip()}};
+
+  auto const scale = reference_.scale();
+  auto const fset_scale = Set{static_cast<Scalar>(scale)};
+  auto const palette_scaling = palette_scale<Set>(maxiter_);
+
+  // Offsets are computed in units of the scale, where they stay close to the pixel indices //
+  auto const step = Complex{Set{static_cast<Scalar>(frame_.width() / resolution_.x / scale)},
+                            Set{static_cast<Scalar>(frame_.height() / resolution_.y / scale)}};
+  auto const origin = Complex{Set{static_cast<Scalar>(frame_.lower.x / scale)},
+                              Set{static_cast<Scalar>(frame_.lower.y / scale)}};
+
+  auto const broadcast = [](Complex<f64> const& val) {
+    return Complex{Set{static_cast<Scalar>(val.real)}, Set{static_cast<Scalar>(val.imag)}};
+  };
+
+  auto const [sa, sb, sc] = reference_.series();
+  auto const series = std::array{broadcast(sa), broadcast(sb), broadcast(sc)};
+
+  auto* const row = row_(y);
+
+  for (auto x = begin; x < end; x += Set::width) {
+    auto const px = Complex<Int>{Int{Lane{x}} + px_x_offset<Set>, Int{Lane{y}}};
+
+    auto const u = Complex{static_cast<Set>(px.real) * step.real + origin.real,
+                           static_cast<Set>(px.imag) * step.imag + origin.imag};
+    auto const dc = Complex{u.real * fset_scale, u.imag * fset_scale};
+
+    auto dz = ((series[2] * u + series[1]) * u + series[0]) * u;
+    auto ref = uset_skip;
+    auto iter = uset_skip - uset_1;
+
+    auto zref = Complex{Set::gather(orbit_re, ref), Set::gather(orbit_im, ref)};
+    auto escaped = (zref + dz).l2sqnorm();
+    auto done = escaped > fset_4;
+
+    if constexpr (stats)
+      ++counters->vectors;
+
+    while (!done.all()) {
+      if constexpr (stats)
+        count_step<Set>(done, counters);
+
+      dz = (Complex{zref.real + zref.real, zref.imag + zref.imag} + dz) * dz + dc;
+
+      ref += uset_1 & ~done;
+      iter += uset_1 & ~done;
+
+      zref = Complex{Set::gather(orbit_re, ref), Set::gather(orbit_im, ref)};
+
+      auto const z = zref + dz;
+      auto const zabssq = z.l2sqnorm();
+
+      if constexpr (color)
+        escaped = escaped.blend(zabssq, ~done);
+
+      done |= (iter >= uset_limiter) | (zabssq > fset_4);
+
+      // Once the pixel comes closer to 0 than to the reference, or the reference runs out, the
+      // orbit is continued from its start (Z_0 = 0) with the full value as the new delta
+      auto const rebase = ((zabssq < dz.l2sqnorm()) | (ref == uset_last)) & ~done;
+
+      dz = Complex{dz.real.blend(z.real, rebase), dz.imag.blend(z.imag, rebase)};
+      zref = Complex{zref.real & ~rebase, zref.imag & ~rebase};
+      ref = ref.blend(uset_0, rebase);
+    }
+
+    if constexpr (color)
+      iter = colorize(iter, escaped, uset_limiter, palette_scaling);
+
+    stream_store_iters(iter, &row[x]);
+  }
+}
+
+template <typename Set, bool interior, bool stats>
+auto Image::calc_points_(Coord const* const points, n32 const count,
+                         WorkerStats* const counters) noexcept -> void {
+  using Int = IntOf<Set>;
+  using Lane = typename Int::Scalar;
+
+  auto const uset_limiter = Int{Lane{maxiter_ - 1U}};
+  auto const scaling = pixel_scaling<Set>(frame_, resolution_);
+
+  auto period = 0U;
+
+  for (auto i = 0U; i < count; i += Set::width) {
+    auto const lanes = std::min(Set::width, count - i);
+
+    // Spare lanes repeat the last point rather than wander off to pixels that may cost more //
+    auto px = Complex<Int>{};
+    for (auto lane = 0U; lane < Set::width; ++lane) {
+      auto const& point = points[i + std::min(lane, lanes - 1U)];
+      px.real.lanes[lane] = Lane{point.x};
+      px.imag.lanes[lane] = Lane{point.y};
+    }
+
+    auto const [c, inside] = map_pixels(px, scaling, frame_);
+    auto const iter = iterate_lockstep<interior, stats>(c, inside, uset_limiter, period, counters);
+
+    for (auto lane = 0U; lane < lanes; ++lane) {
+      auto const& point = points[i + lane];
+      auto const val = static_cast<n32>(iter.lanes[lane]);
+
+      row_(point.y)[point.x] = val;
+
+      if (auto const mirror = mirror_row_(point.y))
+        row_(*mirror)[point.x] = val;
+    }
+  }
+}
+
+template <typename Set, bool interior, bool stats>
+auto Image::calc_reusing_(Rect const& tile, WorkerStats* const counters) noexcept -> n64 {
+  auto const& prev = *previous_;
+  auto const spacing = GenCoord<f64>{frame_.width() / static_cast<f64>(resolution_.x),
+                                     frame_.height() / static_cast<f64>(resolution_.y)};
+  auto const prev_spacing = GenCoord<f64>{prev.frame_.width() / static_cast<f64>(resolution_.x),
+                                          prev.frame_.height() / static_cast<f64>(resolution_.y)};
+
+  // Where a pixel lands among the previous frame's, if within tolerance of one of them //
+  auto const reproject = [&](f64 const pos, f64 const lower, f64 const step, f64 const prev_lower,
+                             f64 const prev_step, n32 const size) -> std::optional<n32> {
+    auto const src = (lower + pos * step - prev_lower) / prev_step;
+    auto const nearest = std::round(src);
+
+    if (std::abs(src - nearest) > reuse_tolerance_ || nearest < 0.0 ||
+        nearest >= static_cast<f64>(size))
+      return std::nullopt;
+    return static_cast<n32>(nearest);
+  };
+
+  // Counts that escaped in both frames are the same either way; those that ran out are only the
+  // same under the same limit
+  auto const prev_limit = prev.maxiter_ - 1U;
+  auto const limit = maxiter_ - 1U;
+  auto const usable = [&](n32 const val) {
+    return (val < prev_limit && val < limit) || (val == prev_limit && prev_limit == limit);
+  };
+
+  // A pixel is only taken from one whose neighbours all count the same, as the count is then
+  // flat around it; next to a band edge or the boundary it may well differ a fraction of a pixel
+  // away, and the error would be carried into every frame after
+  auto const flat = [&](n32 const x, n32 const y, n32 const val) {
+    if (x == 0U || y == 0U || x + 1U == resolution_.x || y + 1U == resolution_.y)
+      return false;
+
+    for (auto ny = y - 1U; ny <= y + 1U; ++ny)
+      for (auto nx = x - 1U; nx <= x + 1U; ++nx)
+        if (prev.row_(ny)[nx] != val)
+          return false;
+    return true;
+  };
+
+  auto reused = n64{};
+
+  // Tiles are never wider than a Points holds //
+  for (auto y = tile.lower.y; y < tile.upper.y; ++y) {
+    auto* const row = row_(y);
+    auto const mirror_y = mirror_row_(y);
+    auto* const mirror = mirror_y ? row_(*mirror_y) : nullptr;
+    auto const src_y = reproject(static_cast<f64>(y), frame_.lower.y, spacing.y,
+                                 prev.frame_.lower.y, prev_spacing.y, resolution_.y);
+
+    // Most rows fall between the previous frame's, and are computed like any other //
+    if (!src_y) {
+      if (kernel_ == Kernel::Refill)
+        calc_refill_<Set, interior, stats>(y, tile.lower.x, tile.upper.x, counters);
+      else
+        calc_lockstep_<Set, interior, stats>(y, tile.lower.x, tile.upper.x, counters);
+      continue;
+    }
+
+    auto points = Points{};
+
+    for (auto x = tile.lower.x; x < tile.upper.x; ++x) {
+      auto const src_x = reproject(static_cast<f64>(x), frame_.lower.x, spacing.x,
+                                   prev.frame_.lower.x, prev_spacing.x, resolution_.x);
+      auto const val = src_x ? prev.row_(*src_y)[*src_x] : 0U;
+
+      if (!src_x || !usable(val) || !flat(*src_x, *src_y, val)) {
+        points.push({x, y});
+        continue;
+      }
+
+      row[x] = val;
+      if (mirror)
+        mirror[x] = val;
+
+      ++reused;
+    }
+
+    calc_points_<Set, interior, stats>(points.data(), points.size(), counters);
+  }
+
+  return reused;
+}
+
+template <typename Set, bool interior, bool stats>
+auto Image::calc_strided_(n32 const y, n32 const begin, n32 const end, n32 const step,
+                          WorkerStats* const counters) noexcept -> void {
+  using Int = IntOf<Set>;
+  using Lane = typename Int::Scalar;
+
+  auto const uset_limiter = Int{Lane{maxiter_ - 1U}};
+  auto const scaling = pixel_scaling<Set>(frame_, resolution_);
+
+  auto* const row = row_(y);
+  auto const mirror_y = mirror_row_(y);
+  auto* const mirror = mirror_y ? row_(*mirror_y) : nullptr;
+
+  auto offsets = Int{};
+  for (auto lane = 0U; lane < Set::width; ++lane)
+    offsets.lanes[lane] = Lane{lane * step};
+
+  auto period = 0U;
+
+  for (auto x = begin; x < end; x += Set::width * step) {
+    auto const px = Complex<Int>{Int{Lane{x}} + offsets, Int{Lane{y}}};
+
+    auto const [c, inside] = map_pixels(px, scaling, frame_);
+
+    auto const iter = iterate_lockstep<interior, stats>(c, inside, uset_limiter, period, counters);
+
+    // Lanes past the end computed pixels of the next tile, which is left to compute them itself //
+    for (auto lane = 0U; lane < Set::width && x + lane * step < end; ++lane) {
+      auto const val = static_cast<n32>(iter.lanes[lane]);
+
+      row[x + lane * step] = val;
+
+      if (mirror)
+        mirror[x + lane * step] = val;
+    }
+  }
+}
+
+template <typename Set, bool interior, bool stats>
+auto Image::calc_pass_(Rect const& tile, WorkerStats* const counters) noexcept -> void {
+  for (auto y = tile.lower.y; y < tile.upper.y; ++y) {
+    auto const rel_y = y - computed_.lower.y;
+
+    if (rel_y % pass_.stride != 0U)
+      continue;
+
+    // Rows of the coarser pass's grid only lack the pixels halfway between its own; other rows
+    // lack every pixel of the grid
+    auto const refined = pass_.coarser != 0U && rel_y % pass_.coarser == 0U;
+    auto const first = refined ? pass_.stride : 0U;
+    auto const step = refined ? pass_.coarser : pass_.stride;
+
+    // Tiles start on every grid, being wider than the coarsest one //
+    if (step != 1U)
+      calc_strided_<Set, interior, stats>(y, tile.lower.x + first, tile.upper.x, step, counters);
+    else if (kernel_ == Kernel::Refill)
+      calc_refill_<Set, interior, stats>(y, tile.lower.x, tile.upper.x, counters);
+    else
+      calc_lockstep_<Set, interior, stats>(y, tile.lower.x, tile.upper.x, counters);
+  }
+}
+
+template <typename Set, bool interior, bool stats>
+auto Image::calc_outlined_(Rect const& tile, WorkerStats* const counters) noexcept -> n64 {
+  auto outline = Points{};
+
+  // Side by side, so that the lanes of a vector hold neighbouring pixels with similar orbits //
+  for (auto x = tile.lower.x; x < tile.upper.x; ++x)
+    outline.push({x, tile.lower.y});
+
+  for (auto y = tile.lower.y + 1U; y < tile.upper.y && tile.width() > 1U; ++y)
+    outline.push({tile.upper.x - 1U, y});
+
+  for (auto x = tile.upper.x - 1U; x-- > tile.lower.x && tile.height() > 1U;)
+    outline.push({x, tile.upper.y - 1U});
+
+  for (auto y = tile.upper.y - 1U; y-- > tile.lower.y + 1U;)
+    outline.push({tile.lower.x, y});
+
+  calc_points_<Set, interior, stats>(outline.data(), outline.size(), counters);
+
+  return calc_subdivided_<Set, interior, stats>(tile, counters);
+}
+
+template <typename Set, bool interior, bool stats>
+auto Image::calc_subdivided_(Rect const& rect, WorkerStats* const counters) noexcept -> n64 {
+  auto const width = rect.width();
+  auto const height = rect.height();
+
+  if (width <= 2U || height <= 2U)
+    return 0U;
+
+  auto const at = [&](n32 const x, n32 const y) -> n32& { return row_(y)[x]; };
+
+  auto const val = at(rect.lower.x, rect.lower.y);
+  auto uniform = true;
+
+  for (auto x = rect.lower.x; uniform && x < rect.upper.x; ++x)
+    uniform = at(x, rect.lower.y) == val && at(x, rect.upper.y - 1U) == val;
+
+  for (auto y = rect.lower.y + 1U; uniform && y < rect.upper.y - 1U; ++y)
+    uniform = at(rect.lower.x, y) == val && at(rect.upper.x - 1U, y) == val;
+
+  auto const inner = Rect{.lower = {rect.lower.x + 1U, rect.lower.y + 1U},
+                          .upper = {rect.upper.x - 1U, rect.upper.y - 1U}};
+
+  if (uniform) {
+    auto filled = n64{};
+
+    for (auto y = inner.lower.y; y < inner.upper.y; ++y) {
+      std::fill_n(&at(inner.lower.x, y), inner.width(), val);
+      filled += inner.width();
+
+      if (auto const mirror = mirror_row_(y)) {
+        std::fill_n(&at(inner.lower.x, *mirror), inner.width(), val);
+        filled += inner.width();
+      }
+    }
+
+    return filled;
+  }
+
+  auto points = Points{};
+
+  if (inner.width() * inner.height() <= min_split_pixels) {
+    for (auto y = inner.lower.y; y < inner.upper.y; ++y)
+      for (auto x = inner.lower.x; x < inner.upper.x; ++x)
+        points.push({x, y});
+
+    calc_points_<Set, interior, stats>(points.data(), points.size(), counters);
+    return 0U;
+  }
+
+  // The halves share the line that splits them, which is all they are missing of an outline //
+  if (width >= height) {
+    auto const mid = rect.lower.x + width / 2U;
+
+    for (auto y = inner.lower.y; y < inner.upper.y; ++y)
+      points.push({mid, y});
+
+    calc_points_<Set, interior, stats>(points.data(), points.size(), counters);
+
+    return calc_subdivided_<Set, interior, stats>(
+               {.lower = rect.lower, .upper = {mid + 1U, rect.upper.y}}, counters) +
+           calc_subdivided_<Set, interior, stats>(
+               {.lower = {mid, rect.lower.y}, .upper = rect.upper}, counters);
+  }
+
+  auto const mid = rect.lower.y + height / 2U;
+
+  for (auto x = inner.lower.x; x < inner.upper.x; ++x)
+    points.push({x, mid});
+
+  calc_points_<Set, interior, stats>(points.data(), points.size(), counters);
+
+  return calc_subdivided_<Set, interior, stats>(
+             {.lower = rect.lower, .upper = {rect.upper.x, mid + 1U}}, counters) +
+         calc_subdivided_<Set, interior, stats>({.lower = {rect.lower.x, mid}, .upper = rect.upper},
+                                                counters);
+}
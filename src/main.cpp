@@ -1,48 +1,753 @@
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdio>
 #include <fmt/core.h>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
 
+#include "animation.h"
+#include "bigfloat.h"
+#include "complex.h"
 #include "conf.h"
+#include "heatmap.h"
 #include "image.h"
+#include "isa.h"
+#include "mapped.h"
+#include "output.h"
+#include "pyramid.h"
+#include "renderer.h"
+#include "server.h"
+#include "stats.h"
+#include "tiles.h"
 #include "util.h"
 
 auto constexpr inline filename_def = "mandelbrot.pgm";
+auto constexpr inline format_def = Format::Gray16;
+auto constexpr inline cache_size_def = Size{1024U} << 20U;
+
+auto constexpr inline usage_str =
+    "Usage: {} [-f ascii|pgm8|pgm16|raw|png|ppm|pngrgba] [-k lockstep|refill]\n"
+    "       [-p auto|f32|f64|perturb] [-m sse2|avx2|avx512] [-s] [-d] [-b MB] [-M]\n"
+    "       [-c RE IM] [-w WIDTH] [-i MAXITER]\n"
+    "       [--deadline MS] [--zoom KEYFILE [--reuse PIXELS]] [--predict] [--stats JSONFILE]\n"
+    "       [--heatmap NAME] [--shard I/N] [--pyramid] FILENAME [XRES YRES]\n"
+    "       {} [options] --cache DIR [--cache-size MB] --tiles LEVEL X Y COLS ROWS FILENAME\n"
+    "       {} [options] --serve SOCKET|-\n";
+
+struct Options {
+  std::string_view filename = filename_def;
+  Format format = format_def;
+  Image::Args args = {};
+  std::optional<Complex<BigFloat>> center;
+  std::optional<f64> width;
+  // Memory for pixels, in bytes; when set, the image is rendered and written in bands //
+  std::optional<Size> budget;
+  // Renders straight into the output file, mapped into memory; raw output only //
+  bool mapped = false;
+  // Renders coarse to fine until this many milliseconds have passed, then writes what is done //
+  std::optional<n32> deadline_ms;
+  // Renders the zoom these keyframes describe, see parse_keyframes() //
+  std::optional<std::string_view> zoom_file;
+  // Frames of a zoom take pixels within this many pixels of one of the frame before from it //
+  std::optional<f64> reuse;
+  // Where to write the stats of every worker, as JSON //
+  std::optional<std::string_view> stats_file;
+  // Heatmap files are named after it, see write_heatmap() //
+  std::optional<std::string_view> heatmap_name;
+  // Renders only the I-th of N bands of rows, into a shard file for mandelbrot_merge //
+  std::optional<std::pair<n32, n32>> shard;
+  // Writes the frame as a Deep Zoom image of every level, see Pyramid //
+  bool pyramid = false;
+  // Answers render requests on this Unix domain socket, or on stdin and stdout if it is "-" //
+  std::optional<std::string_view> serve;
+  // Tiles of the quadtree over the view to render, as one image; see TileAddress //
+  struct Tiles {
+    TileAddress first;
+    n32 cols, rows;
+  };
+  std::optional<Tiles> tiles;
+  // Where the tiles are cached, and how many bytes of them at most //
+  std::optional<std::string_view> cache_dir;
+  Size cache_size = cache_size_def;
+};
+
+namespace {
+
+auto constexpr stoi = [](std::string_view str) {
+  return static_cast<n32>(std::stoul(str.data()));
+};
+
+auto constexpr stod = [](std::string_view str) { return std::stod(str.data()); };
+
+[[nodiscard]] auto parse_options(i32 const argc, char const* const* const argv)
+    -> std::optional<Options> {
+  auto opts = Options{};
+  auto positional = std::vector<std::string_view>{};
+
+  for (auto i = 1; i < argc; ++i) {
+    auto const arg = std::string_view{argv[i]};
+
+    // Fetches the value following an option, if there is one //
+    auto const value = [&]() -> std::optional<std::string_view> {
+      if (i + 1 == argc)
+        return std::nullopt;
+      return argv[++i];
+    };
+
+    if (arg == "-f") {
+      auto const name = value();
+      auto const parsed = name ? parse_format(*name) : std::nullopt;
+      if (!parsed)
+        return std::nullopt;
+
+      opts.format = *parsed;
+    } else if (arg == "-k") {
+      auto const name = value();
+      if (name == "lockstep")
+        opts.args.kernel = Image::Kernel::Lockstep;
+      else if (name == "refill")
+        opts.args.kernel = Image::Kernel::Refill;
+      else
+        return std::nullopt;
+    } else if (arg == "-p") {
+      auto const name = value();
+      if (name == "auto")
+        opts.args.precision = Image::Precision::Auto;
+      else if (name == "f32")
+        opts.args.precision = Image::Precision::Single;
+      else if (name == "f64")
+        opts.args.precision = Image::Precision::Double;
+      else if (name == "perturb")
+        opts.args.precision = Image::Precision::Perturb;
+      else
+        return std::nullopt;
+    } else if (arg == "-m") {
+      auto const name = value();
+      auto const parsed = name ? parse_isa(*name) : std::nullopt;
+      if (!parsed)
+        return std::nullopt;
+
+      opts.args.isa = *parsed;
+    } else if (arg == "-s") {
+      opts.args.subdivide = true;
+    } else if (arg == "-d") {
+      opts.args.interior = true;
+    } else if (arg == "-b") {
+      auto const megabytes = value();
+      if (!megabytes)
+        return std::nullopt;
+
+      opts.budget = Size{stoi(*megabytes)} << 20U;
+    } else if (arg == "-M") {
+      opts.mapped = true;
+    } else if (arg == "--stats") {
+      opts.stats_file = value();
+      if (!opts.stats_file)
+        return std::nullopt;
+
+      opts.args.stats = true;
+    } else if (arg == "--deadline") {
+      auto const ms = value();
+      if (!ms)
+        return std::nullopt;
+
+      opts.deadline_ms = stoi(*ms);
+    } else if (arg == "--zoom") {
+      opts.zoom_file = value();
+      if (!opts.zoom_file)
+        return std::nullopt;
+    } else if (arg == "--reuse") {
+      auto const pixels = value();
+      if (!pixels)
+        return std::nullopt;
+
+      opts.reuse = stod(*pixels);
+    } else if (arg == "--predict") {
+      opts.args.predict = true;
+    } else if (arg == "--heatmap") {
+      opts.heatmap_name = value();
+      if (!opts.heatmap_name)
+        return std::nullopt;
+
+      opts.args.heatmap = true;
+    } else if (arg == "--shard") {
+      auto const spec = value();
+      auto const slash = spec ? spec->find('/') : std::string_view::npos;
+      if (slash == std::string_view::npos)
+        return std::nullopt;
+
+      auto const index = stoi(spec->substr(0U, slash));
+      auto const count = stoi(spec->substr(slash + 1U));
+      if (count == 0U || index >= count)
+        return std::nullopt;
+
+      opts.shard = {index, count};
+    } else if (arg == "--pyramid") {
+      opts.pyramid = true;
+    } else if (arg == "--tiles") {
+      auto words = std::array<std::optional<std::string_view>, 5U>{};
+      for (auto& word : words)
+        word = value();
+      if (!std::ranges::all_of(words, [](auto const& word) { return word.has_value(); }))
+        return std::nullopt;
+
+      auto const level = stoi(*words[0]);
+      auto const tiles = Options::Tiles{.first = {.level = level,
+                                                  .x = std::stoull(words[1]->data()),
+                                                  .y = std::stoull(words[2]->data())},
+                                        .cols = stoi(*words[3]),
+                                        .rows = stoi(*words[4])};
+
+      // Every tile must be one of the level's //
+      auto const side = n64{1U} << std::min(level, max_tile_level);
+      if (level > max_tile_level || tiles.cols == 0U || tiles.rows == 0U ||
+          tiles.first.x >= side || side - tiles.first.x < tiles.cols ||
+          tiles.first.y >= side || side - tiles.first.y < tiles.rows)
+        return std::nullopt;
+
+      opts.tiles = tiles;
+    } else if (arg == "--cache") {
+      opts.cache_dir = value();
+      if (!opts.cache_dir)
+        return std::nullopt;
+    } else if (arg == "--cache-size") {
+      auto const megabytes = value();
+      if (!megabytes)
+        return std::nullopt;
+
+      opts.cache_size = Size{stoi(*megabytes)} << 20U;
+    } else if (arg == "--serve") {
+      opts.serve = value();
+      if (!opts.serve)
+        return std::nullopt;
+    } else if (arg == "-c") {
+      auto const re = value();
+      auto const im = value();
+      if (!re || !im)
+        return std::nullopt;
+
+      // Every decimal digit is worth a bit over 3 bits; the rest is headroom //
+      auto const limbs = BigFloat::limbs_for_bits(static_cast<n32>(4 * (re->size() + im->size())));
+      auto const re_big = BigFloat::parse(*re, limbs);
+      auto const im_big = BigFloat::parse(*im, limbs);
+      if (!re_big || !im_big)
+        return std::nullopt;
+
+      opts.center = Complex{*re_big, *im_big};
+    } else if (arg == "-w") {
+      auto const width = value();
+      if (!width)
+        return std::nullopt;
+
+      opts.width = stod(*width);
+    } else if (arg == "-i") {
+      auto const maxiter = value();
+      if (!maxiter)
+        return std::nullopt;
+
+      opts.args.maxiter = stoi(*maxiter);
+    } else
+      positional.push_back(arg);
+  }
+
+  if (positional.size() == 2 || positional.size() > 3)
+    return std::nullopt;
+
+  // Only raw samples are laid out in the file as the kernels store them //
+  if (opts.mapped && (opts.format != Format::Raw || opts.budget))
+    return std::nullopt;
+
+  // PNG is compressed from the finished image, so it is never streamed //
+  if (is_png(opts.format) && opts.budget)
+    return std::nullopt;
+
+  // Colours are only stored by the kernels that render whole frames or bands of them, and
+  // everything that works on iteration counts after the render needs counts
+  opts.args.color = is_color(opts.format);
+  if (opts.args.color && (opts.deadline_ms || opts.reuse || opts.shard || opts.tiles ||
+                          opts.pyramid || opts.heatmap_name))
+    return std::nullopt;
+
+  // Passes are only complete once they cover the whole image //
+  if (opts.deadline_ms && (opts.budget || opts.mapped))
+    return std::nullopt;
+
+  // Zooms keep whole frames to reuse and write, and are written as a stream or file per frame //
+  if (opts.zoom_file && (opts.budget || opts.mapped || opts.deadline_ms))
+    return std::nullopt;
+
+  if (opts.reuse && !opts.zoom_file)
+    return std::nullopt;
+
+  // Shards are whole renders of their rows, written as raw samples with a header of their own //
+  if (opts.shard && (opts.budget || opts.mapped || opts.deadline_ms || opts.zoom_file))
+    return std::nullopt;
+
+  // Pyramids are written as the frame renders, a strip of tiles of each level at a time //
+  if (opts.pyramid && (opts.budget || opts.mapped || opts.deadline_ms || opts.zoom_file ||
+                       opts.shard || opts.serve || opts.tiles))
+    return std::nullopt;
+
+  // Tiles are rendered through the cache, at their own resolution, and written as one image //
+  if (opts.tiles.has_value() != opts.cache_dir.has_value() ||
+      (opts.tiles && (opts.budget || opts.mapped || opts.deadline_ms || opts.zoom_file ||
+                      opts.shard || opts.serve || opts.stats_file || opts.heatmap_name ||
+                      positional.size() > 1)))
+    return std::nullopt;
+
+  // Servers take every render the same way and have no files of their own to write //
+  if (opts.serve && (opts.budget || opts.mapped || opts.deadline_ms || opts.zoom_file ||
+                     opts.shard || opts.stats_file || opts.heatmap_name || !positional.empty()))
+    return std::nullopt;
+
+  if (!positional.empty())
+    opts.filename = positional[0];
+
+  if (positional.size() > 1)
+    opts.args.resolution = Image::Coord{.x = stoi(positional[1]), .y = stoi(positional[2])};
+
+  // Rows must be a whole number of the narrowest vectors, which are stored whole //
+  if (opts.args.resolution.x == 0U || opts.args.resolution.y == 0U ||
+      opts.args.resolution.x % isa_width(Isa::Sse2) != 0U)
+    return std::nullopt;
+
+  // An explicit view keeps the default centre/width for whatever was left out //
+  if (opts.center || opts.width) {
+    auto const& def = opts.args.frame;
+    auto const width = opts.width.value_or(def.width());
+    auto const height = width * static_cast<f64>(opts.args.resolution.y) /
+                        static_cast<f64>(opts.args.resolution.x);
+
+    opts.args.center = opts.center.value_or(
+        Complex{BigFloat{(def.lower.x + def.upper.x) / 2.0, 2U},
+                BigFloat{(def.lower.y + def.upper.y) / 2.0, 2U}});
+    opts.args.frame = {.lower = {-width / 2.0, -height / 2.0},
+                       .upper = {width / 2.0, height / 2.0}};
+  }
+
+  return opts;
+}
+
+// Writes the lane divergence to NAME-divergence.pgm and the tile costs to NAME-tiles.json //
+[[nodiscard]] auto write_heatmap(std::string_view const name, Heatmap const& heatmap) -> bool {
+  auto const divergence = fmt::format("{}-divergence.pgm", name);
+  auto const tiles = fmt::format("{}-tiles.json", name);
+
+  auto fp = std::fopen(divergence.c_str(), "wb");
+  auto ok = fp && heatmap.write_divergence(fp);
+
+  if (fp)
+    ok = std::fclose(fp) == 0 && ok;
+
+  if (!ok) {
+    fmt::print("Failed to write {}\n", divergence);
+    return false;
+  }
+
+  fp = std::fopen(tiles.c_str(), "w");
+
+  if (!fp) {
+    fmt::print("Failed to write {}\n", tiles);
+    return false;
+  }
+
+  heatmap.write_tiles_json(fp);
+  return std::fclose(fp) == 0;
+}
+
+// Prints what is left to say about a render and writes its stats if asked to, returning the exit
+// code
+[[nodiscard]] auto finish(Options const& opts, Image const& img) -> int {
+  fmt::print("Instruction set: {}\n", isa_name(img.isa()));
+
+  if (img.subdivide()) {
+    auto const pixels = Size{img.resolution().x} * img.resolution().y;
+    fmt::print("Skipped: {} of {} pixels ({:.1f}%)\n", img.skipped(), pixels,
+               100.0 * static_cast<f64>(img.skipped()) / static_cast<f64>(pixels));
+  }
+
+  if (opts.heatmap_name && !write_heatmap(*opts.heatmap_name, *img.heatmap()))
+    return -1;
+
+  if (!opts.stats_file)
+    return 0;
+
+  auto fp = std::fopen(opts.stats_file->data(), "w");
+
+  if (!fp) {
+    fmt::print("Failed to write {}\n", *opts.stats_file);
+    return -1;
+  }
+
+  write_stats_json(fp, img.stats(), img.lanes());
+  return std::fclose(fp) == 0 ? 0 : -1;
+}
+
+// Writes the image out while it renders, whole or in bands, so only the total time is known //
+[[nodiscard]] auto render_to_file(Options const& opts) -> int {
+  auto fp = std::fopen(opts.filename.data(), opts.format == Format::Ascii ? "w" : "wb");
+
+  if (!fp) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const start = std::chrono::high_resolution_clock::now();
+
+  auto renderer = Renderer{opts.args.thread_count};
+  auto img = Image{};
+  auto const ok = opts.budget
+                      ? renderer.render_banded(opts.args, img, fp, opts.format, *opts.budget)
+                      : renderer.render_streamed(opts.args, img, fp, opts.format);
+
+  if ((std::fclose(fp) != 0) || !ok) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const end = std::chrono::high_resolution_clock::now();
+
+  fmt::print("Total time: {}ms\n", to_ms(start, end));
+  return finish(opts, img);
+}
+
+// Renders, then compresses on the same threads, timing both //
+[[nodiscard]] auto render_png(Options const& opts) -> int {
+  auto fp = std::fopen(opts.filename.data(), "wb");
+
+  if (!fp) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const start_comp = std::chrono::high_resolution_clock::now();
+
+  auto renderer = Renderer{opts.args.thread_count};
+  auto img = Image{};
+  renderer.render(opts.args, img);
+
+  auto const end_comp = std::chrono::high_resolution_clock::now();
+
+  auto const ok = renderer.save_png(img, fp);
+  auto const size = std::ftell(fp);
+
+  if ((std::fclose(fp) != 0) || !ok) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const end_save = std::chrono::high_resolution_clock::now();
+
+  // Throughput is measured in bytes of samples encoded, the size the image has uncompressed //
+  auto const bytes = static_cast<f64>(Size{img.resolution().x} * img.resolution().y *
+                                      sample_size(opts.format));
+  auto const save_ms = to_ms(end_comp, end_save);
+
+  fmt::print("Total time: {}ms\n", to_ms(start_comp, end_save));
+  fmt::print("  Computation time: {}ms\n", to_ms(start_comp, end_comp));
+  fmt::print("  Saving time: {}ms ({:.0f} MB/s, {:.1f}% of uncompressed size)\n", save_ms,
+             bytes / 1e3 / std::max(static_cast<f64>(save_ms), 1.0),
+             100.0 * static_cast<f64>(size) / bytes);
+  return finish(opts, img);
+}
+
+// Renders coarse to fine until the deadline, then writes the finest pass done by then //
+[[nodiscard]] auto render_progressive(Options const& opts) -> int {
+  using Clock = std::chrono::steady_clock;
+
+  auto const start = Clock::now();
+  auto const deadline = start + std::chrono::milliseconds{*opts.deadline_ms};
+
+  auto renderer = Renderer{opts.args.thread_count};
+  auto img = Image{};
+
+  auto const passes = renderer.render_progressive(
+      opts.args, img,
+      [&](Image const&, n32 const pass) {
+        fmt::print("Pass {}: {}ms\n", pass + 1U, to_ms(start, Clock::now()));
+      },
+      {}, deadline);
+
+  if (passes == 0U) {
+    fmt::print("Nothing rendered within {}ms\n", *opts.deadline_ms);
+    return -1;
+  }
+
+  auto const end_comp = Clock::now();
+
+  auto ok = true;
+  if (is_png(opts.format)) {
+    auto fp = std::fopen(opts.filename.data(), "wb");
+    ok = fp && renderer.save_png(img, fp);
+    ok = fp && std::fclose(fp) == 0 && ok;
+  } else
+    ok = img.save(opts.filename, opts.format);
+
+  if (!ok) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const end_save = Clock::now();
+
+  fmt::print("Total time: {}ms\n", to_ms(start, end_save));
+  fmt::print("  Computation time: {}ms\n", to_ms(start, end_comp));
+  fmt::print("  Saving time: {}ms\n", to_ms(end_comp, end_save));
+  return finish(opts, img);
+}
+
+// The name of a frame of a zoom: the pattern with {} replaced by its number, if it has one //
+[[nodiscard]] auto frame_filename(std::string_view const pattern, n32 const frame)
+    -> std::optional<std::string> {
+  auto const pos = pattern.find("{}");
+
+  if (pos == std::string_view::npos)
+    return std::nullopt;
+
+  return fmt::format("{}{:05}{}", pattern.substr(0U, pos), frame, pattern.substr(pos + 2U));
+}
+
+// Renders this process's share of the rows of the frame into a shard file //
+[[nodiscard]] auto render_shard(Options const& opts) -> int {
+  auto fp = std::fopen(opts.filename.data(), "wb");
+
+  if (!fp) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  // Shards get the same number of rows give or take one, whichever rows they are mirrored from //
+  auto const [index, count] = *opts.shard;
+  auto const height = Size{opts.args.resolution.y};
+  auto const rows = Image::Band{.begin = static_cast<n32>(height * index / count),
+                                .end = static_cast<n32>(height * (index + 1U) / count)};
+
+  auto const start = std::chrono::high_resolution_clock::now();
+
+  auto renderer = Renderer{opts.args.thread_count};
+  auto img = Image{};
+  auto const ok = renderer.render_shard(opts.args, img, rows, fp);
+
+  if ((std::fclose(fp) != 0) || !ok) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const end = std::chrono::high_resolution_clock::now();
+
+  fmt::print("Total time: {}ms\n", to_ms(start, end));
+  fmt::print("  Rows: {} to {} of {}\n", rows.begin, rows.end, height);
+  return finish(opts, img);
+}
+
+// Renders the frame into the tiles of every level of a Deep Zoom image as its rows finish //
+[[nodiscard]] auto render_pyramid(Options const& opts) -> int {
+  auto const start = std::chrono::high_resolution_clock::now();
+
+  auto const& res = opts.args.resolution;
+  auto pyramid = Pyramid{opts.filename, res.x, res.y, opts.args.maxiter, opts.format};
+
+  auto renderer = Renderer{opts.args.thread_count};
+  auto img = Image{};
+  auto ok = renderer.render_streamed(opts.args, img, [&](n32 const* const rows, n32 const count) {
+    return pyramid.add_rows(rows, count);
+  });
+  ok = ok && pyramid.finish();
+
+  if (!ok) {
+    fmt::print("Failed to write the pyramid of {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const end = std::chrono::high_resolution_clock::now();
+
+  fmt::print("Total time: {}ms\n", to_ms(start, end));
+  fmt::print("  Levels: {}, tiles: {}\n", pyramid.level_count(), pyramid.tile_count());
+  return finish(opts, img);
+}
+
+// Renders a block of tiles of the quadtree through the cache, only computing those not in it //
+[[nodiscard]] auto render_tiles(Options const& opts) -> int {
+  auto fp = std::fopen(opts.filename.data(), opts.format == Format::Ascii ? "w" : "wb");
+
+  if (!fp) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const start = std::chrono::high_resolution_clock::now();
+
+  auto renderer = Renderer{opts.args.thread_count};
+  auto const cache = TileCache{*opts.cache_dir, opts.cache_size};
+  auto const& [first, cols, rows] = *opts.tiles;
+  auto const counts =
+      write_tiles(renderer, cache, opts.args, first, cols, rows, fp, opts.format);
+
+  if ((std::fclose(fp) != 0) || !counts) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const end = std::chrono::high_resolution_clock::now();
+
+  fmt::print("Total time: {}ms\n", to_ms(start, end));
+  fmt::print("  Tiles: {} cached, {} rendered\n", counts->cached, counts->rendered);
+  return 0;
+}
+
+// Answers render requests until the input ends, or for good on a socket //
+[[nodiscard]] auto serve(Options const& opts) -> int {
+  auto server = Server{opts.args};
+  auto const ok = *opts.serve == "-" ? server.serve_stream(STDIN_FILENO, STDOUT_FILENO)
+                                     : server.serve_socket(*opts.serve);
+
+  if (!ok) {
+    fmt::print(stderr, "Failed to serve on {}\n", *opts.serve);
+    return -1;
+  }
+
+  return 0;
+}
+
+// Renders a zoom frame by frame on one pool, each frame written out while the next one renders //
+[[nodiscard]] auto render_zoom(Options const& opts) -> int {
+  auto text = std::string{};
+
+  if (auto fp = std::fopen(opts.zoom_file->data(), "r")) {
+    auto buf = std::array<char, 4096>{};
+    for (auto n = std::fread(buf.data(), 1U, buf.size(), fp); n != 0U;
+         n = std::fread(buf.data(), 1U, buf.size(), fp))
+      text.append(buf.data(), n);
+    std::fclose(fp);
+  }
+
+  auto const keys = parse_keyframes(text);
+
+  if (!keys) {
+    fmt::print("Failed to read keyframes from {}\n", *opts.zoom_file);
+    return -1;
+  }
+
+  // Without a {} in the name, frames are concatenated into one file, which PNG cannot be //
+  auto const per_frame = frame_filename(opts.filename, 0U).has_value();
+  auto stream = per_frame ? nullptr : std::fopen(opts.filename.data(), "wb");
+
+  if (!per_frame && (!stream || is_png(opts.format))) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const start = std::chrono::high_resolution_clock::now();
+
+  auto renderer = Renderer{opts.args.thread_count};
+  auto img = Image{};
+  auto reused = n64{};
+
+  auto const write_frame = [&](Image const& frame, n32 const number) {
+    reused += frame.reused();
+
+    if (per_frame)
+      return frame.save(*frame_filename(opts.filename, number), opts.format);
+
+    auto const& res = frame.resolution();
+    return write_header(stream, opts.format, res.x, res.y, frame.maxiter()) &&
+           write_samples(stream, opts.format, frame.data(), Size{res.x} * res.y, res.x,
+                         frame.maxiter());
+  };
+
+  auto ok = renderer.render_zoom(*keys, opts.args, opts.reuse, img, write_frame);
+
+  if (stream)
+    ok = std::fclose(stream) == 0 && ok;
+
+  if (!ok) {
+    fmt::print("Failed to write {}\n", opts.filename);
+    return -1;
+  }
+
+  auto const end = std::chrono::high_resolution_clock::now();
+  auto const frames = keys->back().frame - keys->front().frame + 1U;
+  auto const pixels = Size{img.resolution().x} * img.resolution().y * frames;
+
+  fmt::print("Total time: {}ms\n", to_ms(start, end));
+  fmt::print("  Frames: {} ({:.1f}ms each)\n", frames,
+             static_cast<f64>(to_ms(start, end)) / static_cast<f64>(frames));
+
+  if (opts.reuse)
+    fmt::print("  Reused: {} of {} pixels ({:.1f}%)\n", reused, pixels,
+               100.0 * static_cast<f64>(reused) / static_cast<f64>(pixels));
+
+  return finish(opts, img);
+}
+
+} // namespace
 
 auto main(i32 const argc, char const* const* const argv) -> int {
   if constexpr (profiling)
     Image{{}};
   else {
-    if (argc == 3 || argc > 4) {
-      fmt::print("Usage: {} FILENAME [XRES YRES]", argv[0]);
+    auto const opts = parse_options(argc, argv);
+
+    if (!opts) {
+      fmt::print(usage_str, argv[0], argv[0], argv[0]);
       return -1;
     }
 
-    auto const filename = (argc > 1) ? argv[1] : filename_def;
+    if (opts->serve)
+      return serve(*opts);
 
-    auto constexpr stoi = [](std::string_view str) {
-      return static_cast<n32>(std::stoul(str.data()));
-    };
+    if (opts->tiles)
+      return render_tiles(*opts);
 
-    auto const args = [=] {
-      if (argc > 2)
-        return Image::Args{.resolution = Image::Coord{.x = stoi(argv[2]), .y = stoi(argv[3])}};
-      else
-        return Image::Args{};
-    }();
+    if (opts->zoom_file)
+      return render_zoom(*opts);
+
+    if (opts->shard)
+      return render_shard(*opts);
+
+    if (opts->pyramid)
+      return render_pyramid(*opts);
+
+    if (opts->deadline_ms)
+      return render_progressive(*opts);
+
+    if (is_png(opts->format))
+      return render_png(*opts);
+
+    if (!opts->mapped)
+      return render_to_file(*opts);
+
+    auto const& res = opts->args.resolution;
+    auto const file = MappedFile::create(opts->filename, Size{res.x} * res.y * sizeof(n32));
+
+    if (!file) {
+      fmt::print("Failed to write {}\n", opts->filename);
+      return -1;
+    }
 
     auto const start_comp = std::chrono::high_resolution_clock::now();
 
-    auto img = Image{args};
+    auto img = Image{};
+    Renderer{opts->args.thread_count}.render(opts->args, img, reinterpret_cast<n32*>(file->data()));
 
     auto const end_comp = std::chrono::high_resolution_clock::now();
 
-    img.save_pgm(filename);
+    // The file already holds the image, which only has to be handed to the kernel //
+    if (!file->sync()) {
+      fmt::print("Failed to write {}\n", opts->filename);
+      return -1;
+    }
 
     auto const end_save = std::chrono::high_resolution_clock::now();
 
     fmt::print("Total time: {}ms\n", to_ms(start_comp, end_save));
     fmt::print("  Computation time: {}ms\n", to_ms(start_comp, end_comp));
     fmt::print("  Saving time: {}ms\n", to_ms(end_comp, end_save));
+    return finish(*opts, img);
   }
 }
@@ -0,0 +1,72 @@
+#include "mapped.h"
+
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+auto MappedFile::create(std::string_view const filename, Size const size) noexcept
+    -> std::optional<MappedFile> {
+  // The name is copied to be sure it is null-terminated //
+  auto const fd = ::open(std::string{filename}.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0)
+    return std::nullopt;
+
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    return std::nullopt;
+  }
+
+  auto* const data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (data == MAP_FAILED) {
+    ::close(fd);
+    return std::nullopt;
+  }
+
+  return MappedFile{fd, static_cast<n8*>(data), size};
+}
+
+auto MappedFile::open(std::string_view const filename) noexcept -> std::optional<MappedFile> {
+  auto const fd = ::open(std::string{filename}.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    return std::nullopt;
+
+  struct stat st = {};
+
+  if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return std::nullopt;
+  }
+
+  auto const size = static_cast<Size>(st.st_size);
+  auto* const data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+  if (data == MAP_FAILED) {
+    ::close(fd);
+    return std::nullopt;
+  }
+
+  return MappedFile{fd, static_cast<n8*>(data), size};
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : fd_{other.fd_}, data_{other.data_}, size_{other.size_} {
+  other.fd_ = -1;
+  other.data_ = nullptr;
+  other.size_ = 0U;
+}
+
+MappedFile::~MappedFile() noexcept {
+  if (data_)
+    ::munmap(data_, size_);
+
+  if (fd_ >= 0)
+    ::close(fd_);
+}
+
+auto MappedFile::sync() const noexcept -> bool { return ::msync(data_, size_, MS_ASYNC) == 0; }
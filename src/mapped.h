@@ -0,0 +1,40 @@
+#pragma once
+
+#include "util.h"
+
+#include <optional>
+#include <string_view>
+
+// A file mapped into memory, created at a fixed size to be written in place or opened to be read //
+class MappedFile {
+public:
+  // Creates or truncates filename to size bytes and maps all of it for writing //
+  [[nodiscard]] static auto create(std::string_view filename, Size size) noexcept
+      -> std::optional<MappedFile>;
+
+  // Maps all of an existing, non-empty file for reading only, so data() must not be written to //
+  [[nodiscard]] static auto open(std::string_view filename) noexcept -> std::optional<MappedFile>;
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+
+  auto operator=(MappedFile const&) -> MappedFile& = delete;
+  auto operator=(MappedFile&&) -> MappedFile& = delete;
+
+  ~MappedFile() noexcept;
+
+  // Page-aligned //
+  [[nodiscard]] auto data() const noexcept { return data_; }
+  [[nodiscard]] auto size() const noexcept { return size_; }
+
+  // Hands the written pages to the kernel for writeback, like closing a file written with fwrite
+  // would; durability is left to the kernel just the same
+  [[nodiscard]] auto sync() const noexcept -> bool;
+
+private:
+  MappedFile(int fd, n8* data, Size size) noexcept : fd_{fd}, data_{data}, size_{size} {}
+
+  int fd_ = -1;
+  n8* data_ = nullptr;
+  Size size_ = 0U;
+};
@@ -0,0 +1,437 @@
+#include "output.h"
+#include "set_sse2.h"
+#include "util.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fmt/compile.h>
+#include <fmt/core.h>
+#include <immintrin.h>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <utility>
+#include <zlib.h>
+
+namespace {
+
+using namespace simd::sse2;
+
+[[nodiscard]] auto scale_factor(Format const format, n32 const maxiter) noexcept -> f32 {
+  return static_cast<f32>(sample_max(format, maxiter)) / static_cast<f32>(maxiter);
+}
+
+[[nodiscard]] auto scale_sample(n32 const val, f32 const factor) noexcept -> n32 {
+  return static_cast<n32>(static_cast<f32>(val) * factor + 0.5F);
+}
+
+[[nodiscard]] auto scale_set(IntSet<i32> const& val, FloatSet const& factor) noexcept
+    -> IntSet<i32> {
+  return static_cast<IntSet<i32>>(static_cast<FloatSet>(val) * factor + 0.5F);
+}
+
+// Encoding is bound by memory and the write that follows, so the baseline sets are used on every
+// CPU. SSE2 only packs with signed saturation, which both encoders work around
+auto encode_gray8(n32 const* const src, Size const count, n32 const maxiter,
+                  n8* const dst) noexcept -> void {
+  auto constexpr step = 4 * sizeof(__m128i) / sizeof(n32);
+  auto const factor = scale_factor(Format::Gray8, maxiter);
+  auto const fset_factor = FloatSet{factor};
+
+  auto i = Size{};
+  for (; i + step <= count; i += step) {
+    auto const v0 = scale_set(IntSet<i32>::load_unaligned(&src[i]), fset_factor);
+    auto const v1 = scale_set(IntSet<i32>::load_unaligned(&src[i + 4]), fset_factor);
+    auto const v2 = scale_set(IntSet<i32>::load_unaligned(&src[i + 8]), fset_factor);
+    auto const v3 = scale_set(IntSet<i32>::load_unaligned(&src[i + 12]), fset_factor);
+
+    // Scaled samples never exceed 255, so the signed 16-bit stage cannot saturate //
+    auto const lo = _mm_packs_epi32(v0.vec, v1.vec);
+    auto const hi = _mm_packs_epi32(v2.vec, v3.vec);
+
+    IntSet<n8>{_mm_packus_epi16(lo, hi)}.store_unaligned(&dst[i]);
+  }
+
+  for (; i < count; ++i)
+    dst[i] = static_cast<n8>(std::min(scale_sample(src[i], factor), 255U));
+}
+
+auto encode_gray16(Format const format, n32 const* const src, Size const count,
+                   n32 const maxiter, n8* const dst) noexcept -> void {
+  auto constexpr step = 2 * sizeof(__m128i) / sizeof(n32);
+  auto const scaled = maxiter != sample_max(format, maxiter);
+  auto const factor = scale_factor(format, maxiter);
+  auto const fset_factor = FloatSet{factor};
+
+  // Samples are biased into the signed range for packing, then the bias is flipped back //
+  auto const bias = IntSet<i32>{0x8000};
+  auto const sign = IntSet<i16>{i16{-0x7FFF - 1}};
+
+  auto i = Size{};
+  for (; i + step <= count; i += step) {
+    auto v0 = IntSet<i32>::load_unaligned(&src[i]);
+    auto v1 = IntSet<i32>::load_unaligned(&src[i + 4]);
+
+    if (scaled) {
+      v0 = scale_set(v0, fset_factor);
+      v1 = scale_set(v1, fset_factor);
+    }
+
+    auto const words = IntSet<i16>{_mm_packs_epi32((v0 - bias).vec, (v1 - bias).vec)} ^ sign;
+
+    // PGM stores multi-byte samples MSB first //
+    IntSet<n16>{_mm_or_si128(_mm_slli_epi16(words.vec, 8), _mm_srli_epi16(words.vec, 8))}
+        .store_unaligned(&dst[2 * i]);
+  }
+
+  for (; i < count; ++i) {
+    auto const val = std::min(scaled ? scale_sample(src[i], factor) : src[i], 65535U);
+    dst[2 * i] = static_cast<n8>(val >> 8U);
+    dst[2 * i + 1] = static_cast<n8>(val);
+  }
+}
+
+// Colours are stored as RGBA with red in the lowest byte, so dropping every 4th byte leaves RGB //
+auto encode_rgb(n32 const* const src, Size const count, n8* const dst) noexcept -> void {
+  for (auto i = Size{}; i < count; ++i) {
+    dst[3U * i] = static_cast<n8>(src[i]);
+    dst[3U * i + 1U] = static_cast<n8>(src[i] >> 8U);
+    dst[3U * i + 2U] = static_cast<n8>(src[i] >> 16U);
+  }
+}
+
+// Deflate effort for PNG strips: past this, the encoder spends far more time for a few percent //
+auto constexpr png_level = 3;
+
+enum class PngFilter : n8 { None, Sub, Up, Paeth = 4 };
+
+[[nodiscard]] auto paeth(i32 const a, i32 const b, i32 const c) noexcept -> i32 {
+  auto const pa = std::abs(b - c);
+  auto const pb = std::abs(a - c);
+  auto const pc = std::abs(a + b - 2 * c);
+
+  return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+}
+
+// Filters one row of size bytes into dst, whose first byte takes the filter type; pixels are bpp
+// bytes each, a 16-bit grey sample or an RGBA colour. Every filter is tried in scratch, which
+// holds 3 * size bytes, and the one whose output bytes are closest to zero kept, as libpng does
+auto filter_row(n8 const* const cur, n8 const* const prev, Size const size, Size const bpp,
+                n8* const dst, n8* const scratch) noexcept -> void {
+  auto* const sub = scratch;
+  auto* const up = scratch + size;
+  auto* const pae = scratch + 2U * size;
+
+  for (auto i = Size{}; i < size; ++i) {
+    auto const a = i >= bpp ? cur[i - bpp] : n8{};
+    auto const b = prev ? prev[i] : n8{};
+    auto const c = prev && i >= bpp ? prev[i - bpp] : n8{};
+
+    sub[i] = static_cast<n8>(cur[i] - a);
+    up[i] = static_cast<n8>(cur[i] - b);
+    pae[i] = static_cast<n8>(cur[i] - paeth(a, b, c));
+  }
+
+  auto const cost = [size](n8 const* const row) {
+    auto sum = n64{};
+    for (auto i = Size{}; i < size; ++i)
+      sum += static_cast<n64>(std::abs(static_cast<i32>(static_cast<i8>(row[i]))));
+    return sum;
+  };
+
+  auto best = PngFilter::None;
+  auto const* best_row = cur;
+  auto best_cost = cost(cur);
+
+  for (auto const& [filter, row] : {std::pair{PngFilter::Sub, sub}, std::pair{PngFilter::Up, up},
+                                   std::pair{PngFilter::Paeth, pae}})
+    if (auto const c = cost(row); c < best_cost) {
+      best = filter;
+      best_row = row;
+      best_cost = c;
+    }
+
+  dst[0] = utype_cast(best);
+  std::memcpy(&dst[1], best_row, size);
+}
+
+auto put_be32(n8* const dst, n32 const val) noexcept -> void {
+  dst[0] = static_cast<n8>(val >> 24U);
+  dst[1] = static_cast<n8>(val >> 16U);
+  dst[2] = static_cast<n8>(val >> 8U);
+  dst[3] = static_cast<n8>(val);
+}
+
+// Writes a chunk of the given type with data gathered from several pieces //
+auto write_chunk(std::FILE* const fp, char const (&type)[5],
+                 std::initializer_list<std::span<n8 const>> const pieces) noexcept -> bool {
+  auto length = Size{};
+  auto crc = crc32(0L, nullptr, 0U);
+
+  crc = crc32(crc, reinterpret_cast<n8 const*>(type), 4U);
+  // zlib takes a null buffer as a request for the initial value, so empty pieces are skipped //
+  for (auto const piece : pieces)
+    if (!piece.empty()) {
+      length += piece.size();
+      crc = crc32_z(crc, piece.data(), piece.size());
+    }
+
+  auto head = std::array<n8, 8>{};
+  auto tail = std::array<n8, 4>{};
+  put_be32(head.data(), static_cast<n32>(length));
+  std::memcpy(&head[4], type, 4U);
+  put_be32(tail.data(), static_cast<n32>(crc));
+
+  auto ok = std::fwrite(head.data(), 1U, head.size(), fp) == head.size();
+  for (auto const piece : pieces)
+    ok = ok && std::fwrite(piece.data(), 1U, piece.size(), fp) == piece.size();
+
+  return ok && std::fwrite(tail.data(), 1U, tail.size(), fp) == tail.size();
+}
+
+} // namespace
+
+auto parse_format(std::string_view const name) noexcept -> std::optional<Format> {
+  if (name == "ascii" || name == "p2")
+    return Format::Ascii;
+  if (name == "pgm8")
+    return Format::Gray8;
+  if (name == "pgm16" || name == "pgm")
+    return Format::Gray16;
+  if (name == "raw")
+    return Format::Raw;
+  if (name == "png")
+    return Format::Png;
+  if (name == "ppm")
+    return Format::Ppm;
+  if (name == "pngrgba")
+    return Format::PngRgba;
+
+  return std::nullopt;
+}
+
+auto is_color(Format const format) noexcept -> bool {
+  return format == Format::Ppm || format == Format::PngRgba;
+}
+
+auto is_png(Format const format) noexcept -> bool {
+  return format == Format::Png || format == Format::PngRgba;
+}
+
+auto sample_size(Format const format) noexcept -> Size {
+  switch (format) {
+  case Format::Ascii:
+    return 0;
+  case Format::Gray8:
+    return sizeof(n8);
+  case Format::Gray16:
+  case Format::Png:
+    return sizeof(n16);
+  case Format::Ppm:
+    return 3U;
+  case Format::Raw:
+  case Format::PngRgba:
+    return sizeof(n32);
+  }
+
+  return 0;
+}
+
+auto sample_max(Format const format, n32 const maxiter) noexcept -> n32 {
+  switch (format) {
+  case Format::Gray8:
+  case Format::Ppm:
+  case Format::PngRgba:
+    return 255U;
+  case Format::Gray16:
+    return std::min(maxiter, 65535U);
+  case Format::Png:
+    return 65535U;
+  case Format::Ascii:
+  case Format::Raw:
+    break;
+  }
+
+  return maxiter;
+}
+
+auto write_header(std::FILE* const fp, Format const format, n32 const width, n32 const height,
+                  n32 const maxiter) noexcept -> bool {
+  switch (format) {
+  case Format::Ascii:
+    fmt::print(fp, "P2\n{} {} \n{} \n", width, height, maxiter);
+    break;
+  case Format::Gray8:
+  case Format::Gray16:
+    fmt::print(fp, "P5\n{} {}\n{}\n", width, height, sample_max(format, maxiter));
+    break;
+  case Format::Ppm:
+    fmt::print(fp, "P6\n{} {}\n255\n", width, height);
+    break;
+  case Format::Raw:
+    break;
+  case Format::Png:
+  case Format::PngRgba:
+    return false;
+  }
+
+  return !std::ferror(fp);
+}
+
+auto encode_samples(Format const format, n32 const* const src, Size const count,
+                    n32 const maxiter, n8* const dst) noexcept -> void {
+  switch (format) {
+  case Format::Gray8:
+    encode_gray8(src, count, maxiter, dst);
+    break;
+  case Format::Gray16:
+  case Format::Png:
+    encode_gray16(format, src, count, maxiter, dst);
+    break;
+  case Format::Ppm:
+    encode_rgb(src, count, dst);
+    break;
+  case Format::Raw:
+  case Format::PngRgba:
+    std::memcpy(dst, src, count * sizeof(n32));
+    break;
+  case Format::Ascii:
+    break;
+  }
+}
+
+auto write_samples(std::FILE* const fp, Format const format, n32 const* const src,
+                   Size const count, n32 const width, n32 const maxiter) noexcept -> bool {
+  if (is_png(format))
+    return false;
+
+  if (format == Format::Ascii) {
+    for (auto i = Size{}; i < count; ++i) {
+      if (i % width == 0)
+        std::putc('\n', fp);
+
+      auto const s = fmt::format(FMT_COMPILE("{} "), src[i]);
+      std::fwrite(s.c_str(), sizeof(char), s.size(), fp);
+    }
+
+    return !std::ferror(fp);
+  }
+
+  // Raw needs no conversion, so it is written straight from the source //
+  if (format == Format::Raw)
+    return std::fwrite(src, sizeof(n32), count, fp) == count;
+
+  auto constexpr chunk_size = Size{1} << 20U;
+
+  auto const stride = sample_size(format);
+  auto const chunk = std::min(chunk_size, count);
+  auto buf = std::unique_ptr<n8[]>{new n8[chunk * stride]};
+
+  auto ok = true;
+  for (auto i = Size{}; ok && i < count; i += chunk) {
+    auto const n = std::min(chunk, count - i);
+
+    encode_samples(format, &src[i], n, maxiter, buf.get());
+    ok = std::fwrite(buf.get(), stride, n, fp) == n;
+  }
+
+  return ok;
+}
+
+auto encode_png_strip(n32 const* const src, n32 const* const above, n32 const width,
+                      n32 const rows, n32 const maxiter, bool const last,
+                      Format const format) noexcept -> PngStrip {
+  auto const bpp = sample_size(format);
+  auto const row_size = Size{width} * bpp;
+  auto const length = (row_size + 1U) * rows;
+
+  auto samples = std::vector<n8>(2U * row_size);
+  auto scratch = std::vector<n8>(3U * row_size);
+  auto filtered = std::vector<n8>(length);
+  auto* cur = samples.data();
+  auto* prev = above ? samples.data() + row_size : nullptr;
+
+  if (above)
+    encode_samples(format, above, width, maxiter, prev);
+
+  for (auto y = 0U; y < rows; ++y) {
+    encode_samples(format, &src[Size{y} * width], width, maxiter, cur);
+    filter_row(cur, prev, row_size, bpp, &filtered[(row_size + 1U) * y], scratch.data());
+
+    prev = cur;
+    cur = cur == samples.data() ? samples.data() + row_size : samples.data();
+  }
+
+  auto strip = PngStrip{.data = {},
+                        .adler = static_cast<n32>(adler32_z(1L, filtered.data(), length)),
+                        .length = length};
+
+  // Raw deflate, as the zlib header and checksum of the whole stream are written around it //
+  auto stream = z_stream{};
+  if (deflateInit2(&stream, png_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return strip;
+
+  // A sync flush ends the strip on a byte boundary without ending the stream, which only the
+  // last strip does
+  strip.data.resize(deflateBound(&stream, length) + 16U);
+  stream.next_in = filtered.data();
+  stream.avail_in = static_cast<uInt>(length);
+  stream.next_out = strip.data.data();
+  stream.avail_out = static_cast<uInt>(strip.data.size());
+
+  auto const status = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+  auto const done = last ? status == Z_STREAM_END : status == Z_OK && stream.avail_in == 0U;
+
+  strip.data.resize(done ? stream.total_out : 0U);
+  deflateEnd(&stream);
+
+  return strip;
+}
+
+auto write_png(std::FILE* const fp, n32 const width, n32 const height, n32 const maxiter,
+               std::span<PngStrip const> const strips, Format const format) noexcept -> bool {
+  auto constexpr signature = std::array<n8, 8>{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+  // 16-bit grayscale or 8-bit RGBA, deflate, adaptive filtering, no interlacing //
+  auto header = std::array<n8, 13>{0, 0, 0, 0, 0, 0, 0, 0, 16, 0, 0, 0, 0};
+  put_be32(&header[0], width);
+  put_be32(&header[4], height);
+
+  if (format == Format::PngRgba) {
+    header[8] = 8;
+    header[9] = 6;
+  }
+
+  // The scale of the samples is only known from maxiter, so it goes along with them //
+  auto const comment = fmt::format("Comment{}maxiter={}", '\0', maxiter);
+
+  // Deflate with a 32K window, level hint "fast" //
+  auto constexpr zlib_header = std::array<n8, 2>{0x78, 0x5E};
+
+  auto ok = std::fwrite(signature.data(), 1U, signature.size(), fp) == signature.size();
+  ok = ok && write_chunk(fp, "IHDR", {header});
+  ok = ok && write_chunk(fp, "tEXt", {{reinterpret_cast<n8 const*>(comment.data()),
+                                       comment.size()}});
+
+  auto adler = adler32(0L, nullptr, 0U);
+  for (auto i = Size{}; ok && i < strips.size(); ++i) {
+    auto const& strip = strips[i];
+    auto const first = i == 0U;
+    auto const last = i + 1U == strips.size();
+
+    ok = !strip.data.empty();
+    adler = adler32_combine(adler, strip.adler, static_cast<z_off_t>(strip.length));
+
+    auto trailer = std::array<n8, 4>{};
+    put_be32(trailer.data(), static_cast<n32>(adler));
+
+    ok = ok && write_chunk(fp, "IDAT",
+                           {first ? std::span<n8 const>{zlib_header} : std::span<n8 const>{},
+                            strip.data,
+                            last ? std::span<n8 const>{trailer} : std::span<n8 const>{}});
+  }
+
+  return ok && write_chunk(fp, "IEND", {});
+}
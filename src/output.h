@@ -0,0 +1,66 @@
+#pragma once
+
+#include "util.h"
+
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+enum class Format : n8 {
+  Ascii,  // P2, one decimal sample per pixel
+  Gray8,  // P5, 8-bit samples scaled to 255
+  Gray16, // P5, 16-bit big-endian samples (scaled only if maxiter exceeds 65535)
+  Raw,    // Headerless native-endian n32 dump of the iteration counts
+  Png,    // 16-bit grayscale PNG, samples scaled to 65535 (losslessly up to a maxiter of 65535)
+  Ppm,    // P6, 8-bit RGB colours from the palette
+  PngRgba // 8-bit RGBA PNG of the colours from the palette, filtered as the kernels store them
+};
+
+[[nodiscard]] auto parse_format(std::string_view name) noexcept -> std::optional<Format>;
+
+// Formats of colours rather than iteration counts, which the image must be rendered as, see
+// Image::Args::color
+[[nodiscard]] auto is_color(Format format) noexcept -> bool;
+
+[[nodiscard]] auto is_png(Format format) noexcept -> bool;
+
+// Bytes per pixel in the encoded stream; 0 for variable-length formats //
+[[nodiscard]] auto sample_size(Format format) noexcept -> Size;
+
+// Largest sample value the format can hold for a given maxiter //
+[[nodiscard]] auto sample_max(Format format, n32 maxiter) noexcept -> n32;
+
+// The stream formats are written as a header and then samples; PNGs are not stream formats and
+// are written with encode_png_strip() and write_png() instead
+auto write_header(std::FILE* fp, Format format, n32 width, n32 height, n32 maxiter) noexcept
+    -> bool;
+
+// Encodes count iteration counts into dst, which must hold count * sample_size(format) bytes //
+auto encode_samples(Format format, n32 const* src, Size count, n32 maxiter, n8* dst) noexcept
+    -> void;
+
+// Writes count samples following the header, a whole number of rows of width pixels //
+auto write_samples(std::FILE* fp, Format format, n32 const* src, Size count, n32 width,
+                   n32 maxiter) noexcept -> bool;
+
+// Rows of a PNG are filtered and deflated in strips independent of each other, so that strips can
+// be encoded in parallel and their outputs joined into a single zlib stream
+auto constexpr inline png_strip_rows = 64U;
+
+struct PngStrip {
+  std::vector<n8> data; // Deflate blocks, empty if encoding failed
+  n32 adler;            // Of the filtered rows that were deflated
+  Size length;          // Of the filtered rows that were deflated
+};
+
+// Encodes rows rows of width pixels in one of the PNG formats; above is the row before the first,
+// or null at the top of the image, and last marks the strip that ends the image
+[[nodiscard]] auto encode_png_strip(n32 const* src, n32 const* above, n32 width, n32 rows,
+                                    n32 maxiter, bool last, Format format = Format::Png) noexcept
+    -> PngStrip;
+
+// Writes a complete PNG file from its strips, in order //
+auto write_png(std::FILE* fp, n32 width, n32 height, n32 maxiter, std::span<PngStrip const> strips,
+               Format format = Format::Png) noexcept -> bool;
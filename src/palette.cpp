@@ -0,0 +1,62 @@
+#include "palette.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace {
+
+struct Stop {
+  f64 pos;
+  std::array<f64, 3> rgb;
+};
+
+// Deep blue through white and orange to black and back, so the outermost bands and the ones
+// nearest the set stand apart from each other
+auto constexpr stops = std::array{
+    Stop{.pos = 0.0, .rgb = {0.0, 7.0, 100.0}},
+    Stop{.pos = 0.16, .rgb = {32.0, 107.0, 203.0}},
+    Stop{.pos = 0.42, .rgb = {237.0, 255.0, 255.0}},
+    Stop{.pos = 0.6425, .rgb = {255.0, 170.0, 0.0}},
+    Stop{.pos = 0.8575, .rgb = {0.0, 2.0, 0.0}},
+    Stop{.pos = 1.0, .rgb = {0.0, 7.0, 100.0}},
+};
+
+[[nodiscard]] auto gradient(f64 const t) noexcept -> n32 {
+  auto const* const upper =
+      std::ranges::find_if(stops, [t](Stop const& stop) { return stop.pos >= t; });
+  auto const* const lower = upper == stops.begin() ? upper : upper - 1;
+  auto const span = upper->pos - lower->pos;
+  auto const w = span > 0.0 ? (t - lower->pos) / span : 0.0;
+
+  auto rgba = 0xFF000000U;
+  for (auto i = 0U; i < 3U; ++i) {
+    auto const val = lower->rgb[i] + (upper->rgb[i] - lower->rgb[i]) * w;
+    rgba |= static_cast<n32>(std::lround(std::clamp(val, 0.0, 255.0))) << (8U * i);
+  }
+
+  return rgba;
+}
+
+// Most pixels escape within a small fraction of maxiter, so the gradient is spread over the
+// square root of the normalised count, which gives them most of it
+template <typename T> [[nodiscard]] auto build() noexcept -> std::array<T, palette_size> {
+  auto ret = std::array<T, palette_size>{};
+
+  for (auto i = 0U; i < palette_size; ++i)
+    ret[i] = gradient(std::sqrt(static_cast<f64>(i) / static_cast<f64>(palette_size - 1U)));
+
+  return ret;
+}
+
+} // namespace
+
+template <> auto palette<n32>() noexcept -> n32 const* {
+  static auto const entries = build<n32>();
+  return entries.data();
+}
+
+template <> auto palette<n64>() noexcept -> n64 const* {
+  static auto const entries = build<n64>();
+  return entries.data();
+}
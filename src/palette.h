@@ -0,0 +1,18 @@
+#pragma once
+
+#include "util.h"
+
+// Entries of the palette that the colour formats look continuous iteration counts up in, the
+// counts being normalised to [0, 1) of maxiter first. Entries are packed RGBA, red in the lowest
+// byte, so that they lie in memory as the bytes of an RGBA image do
+auto constexpr inline palette_size = 4096U;
+
+// Colour of the pixels that never escape //
+auto constexpr inline interior_rgba = 0xFF000000U;
+
+// The palette, its entries widened to T, n32 or n64, so that vectors of either width of lane can
+// gather from it. Built on first use
+template <typename T> [[nodiscard]] auto palette() noexcept -> T const*;
+
+template <> [[nodiscard]] auto palette<n32>() noexcept -> n32 const*;
+template <> [[nodiscard]] auto palette<n64>() noexcept -> n64 const*;
@@ -0,0 +1,101 @@
+#include "perturb.h"
+#include "util.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+auto Reference::compute(Complex<BigFloat> const& center, Complex<f64> const& lower,
+                        Complex<f64> const& spacing, n32 const width, n32 const height,
+                        n32 const maxiter, f64 const tolerance) noexcept -> Reference {
+  auto ref = Reference{};
+  ref.scale_ = std::max(spacing.real, spacing.imag);
+
+  // Iterating the reference with 64 bits to spare below the pixel spacing keeps it exact to well
+  // below what the f64 deltas can resolve
+  auto const bits = static_cast<n32>(std::max(0.0, -std::log2(ref.scale_))) + 64U;
+  auto const limbs = BigFloat::limbs_for_bits(bits);
+
+  auto const c = Complex{center.real.with_limbs(limbs), center.imag.with_limbs(limbs)};
+  auto z = Complex{BigFloat{limbs}, BigFloat{limbs}};
+
+  ref.re_.reserve(Size{maxiter} + 1);
+  ref.im_.reserve(Size{maxiter} + 1);
+  ref.re_.push_back(0.0);
+  ref.im_.push_back(0.0);
+
+  for (auto i = 0U; i < maxiter; ++i) {
+    auto const re_sq = z.real * z.real;
+    auto const im_sq = z.imag * z.imag;
+    auto const cross = z.real * z.imag;
+
+    z = Complex{re_sq - im_sq + c.real, cross + cross + c.imag};
+
+    auto const zf = Complex{z.real.to_f64(), z.imag.to_f64()};
+    ref.re_.push_back(zf.real);
+    ref.im_.push_back(zf.imag);
+
+    if (zf.l2sqnorm() > 4.0)
+      break;
+  }
+
+  ref.re32_.assign(ref.re_.cbegin(), ref.re_.cend());
+  ref.im32_.assign(ref.im_.cbegin(), ref.im_.cend());
+
+  // Corners and edge midpoints bound the error of every pixel in between //
+  auto probes = std::array<Complex<f64>, 9>{};
+  auto deltas = std::array<Complex<f64>, 9>{};
+
+  for (auto i = 0U; i < probes.size(); ++i) {
+    auto const px = Complex{static_cast<f64>(i % 3) * (width - 1) / 2.0,
+                            static_cast<f64>(i / 3) * (height - 1) / 2.0};
+    probes[i] = Complex{(lower.real + px.real * spacing.real) / ref.scale_,
+                        (lower.imag + px.imag * spacing.imag) / ref.scale_};
+    deltas[i] = Complex{probes[i].real * ref.scale_, probes[i].imag * ref.scale_};
+  }
+
+  auto const s = Complex{ref.scale_, 0.0};
+  auto const two = Complex{2.0, 0.0};
+  auto a = s;
+  auto b = Complex{0.0, 0.0};
+  auto cc = Complex{0.0, 0.0};
+
+  // Pixels must start short of the last orbit point, the one they rebase from //
+  for (auto n = 1U; n + 2 < ref.length(); ++n) {
+    auto const zn = Complex{ref.re_[n], ref.im_[n]};
+    auto const zn2 = two * zn;
+
+    auto const a_next = zn2 * a + s;
+    auto const b_next = zn2 * b + a * a;
+    auto const c_next = zn2 * cc + two * a * b;
+
+    auto const znext = Complex{ref.re_[n + 1], ref.im_[n + 1]};
+    auto valid = true;
+
+    for (auto i = 0U; i < probes.size() && valid; ++i) {
+      auto const u = probes[i];
+      auto const dc = Complex{u.real * ref.scale_, u.imag * ref.scale_};
+
+      deltas[i] = (zn2 + deltas[i]) * deltas[i] + dc;
+
+      auto const approx = a_next * u + b_next * u * u + c_next * u * u * u;
+      auto const err = (approx - deltas[i]).l2sqnorm();
+      auto const full = (znext + deltas[i]).l2sqnorm();
+
+      // Pixels must neither escape nor need rebasing within the skipped iterations //
+      valid = full <= 4.0 && full >= deltas[i].l2sqnorm() &&
+              err <= tolerance * tolerance * deltas[i].l2sqnorm();
+    }
+
+    if (!valid)
+      break;
+
+    a = a_next;
+    b = b_next;
+    cc = c_next;
+    ref.skip_ = n + 1;
+  }
+
+  ref.series_ = {a, b, cc};
+  return ref;
+}
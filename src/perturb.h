@@ -0,0 +1,54 @@
+#pragma once
+
+#include "bigfloat.h"
+#include "complex.h"
+#include "util.h"
+
+#include <array>
+#include <vector>
+
+// Orbit of a high-precision reference point, against which every pixel only iterates its small
+// offset (perturbation). The leading iterations are skipped for all pixels at once by evaluating a
+// cubic series in the pixel offset, which the orbit computation validates on the frame's corners.
+class Reference {
+public:
+  // Pixel (x, y) lies at center + lower + (x, y) * spacing. Iterations are only skipped while the
+  // series stays within tolerance of the deltas relative to their size, which should be about the
+  // precision the deltas are later iterated in
+  [[nodiscard]] static auto compute(Complex<BigFloat> const& center, Complex<f64> const& lower,
+                                    Complex<f64> const& spacing, n32 width, n32 height,
+                                    n32 maxiter, f64 tolerance) noexcept -> Reference;
+
+  // Z_0 = 0 up to the iteration at which the reference escaped or hit maxiter //
+  template <typename T> [[nodiscard]] auto orbit_re() const noexcept -> std::vector<T> const& {
+    if constexpr (sizeof(T) == sizeof(f32))
+      return re32_;
+    else
+      return re_;
+  }
+
+  template <typename T> [[nodiscard]] auto orbit_im() const noexcept -> std::vector<T> const& {
+    if constexpr (sizeof(T) == sizeof(f32))
+      return im32_;
+    else
+      return im_;
+  }
+
+  [[nodiscard]] auto length() const noexcept { return static_cast<n32>(re_.size()); }
+
+  // Pixel offsets are expressed in units of scale() so the series stays within f64 range //
+  [[nodiscard]] auto scale() const noexcept { return scale_; }
+
+  // Iteration every pixel starts at, with delta a*u + b*u^2 + c*u^3 for offset u //
+  [[nodiscard]] auto skip() const noexcept { return skip_; }
+  [[nodiscard]] auto series() const noexcept { return series_; }
+
+private:
+  std::vector<f64> re_, im_;
+  std::vector<f32> re32_, im32_;
+
+  f64 scale_ = 1.0;
+  n32 skip_ = 1U;
+  std::array<Complex<f64>, 3> series_ = {Complex{0.0, 0.0}, Complex{0.0, 0.0},
+                                               Complex{0.0, 0.0}};
+};
@@ -0,0 +1,219 @@
+#include "pyramid.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fmt/core.h>
+#include <immintrin.h>
+#include <system_error>
+
+namespace {
+
+// Tiles are written in PNG strips, and the rows of a level are averaged in pairs within a strip //
+static_assert(pyramid_tile_pixels % png_strip_rows == 0U);
+static_assert(pyramid_tile_pixels % 2U == 0U);
+
+[[nodiscard]] auto extension(Format const format) noexcept -> char const* {
+  switch (format) {
+  case Format::Ascii:
+  case Format::Gray8:
+  case Format::Gray16:
+    return "pgm";
+  case Format::Raw:
+    return "raw";
+  case Format::Ppm:
+    return "ppm";
+  case Format::Png:
+  case Format::PngRgba:
+    return "png";
+  }
+
+  return "";
+}
+
+// Quarters of each lane and the rest of them, which add up to a rounded mean that cannot overflow
+// whatever maxiter is
+[[nodiscard]] auto mean4(n32 const a, n32 const b, n32 const c, n32 const d) noexcept -> n32 {
+  return (a >> 2U) + (b >> 2U) + (c >> 2U) + (d >> 2U) +
+         (((a & 3U) + (b & 3U) + (c & 3U) + (d & 3U) + 2U) >> 2U);
+}
+
+[[nodiscard]] auto mean4(__m128i const a, __m128i const b, __m128i const c,
+                         __m128i const d) noexcept -> __m128i {
+  auto const low = _mm_set1_epi32(3);
+  auto const quarters = _mm_add_epi32(_mm_add_epi32(_mm_srli_epi32(a, 2), _mm_srli_epi32(b, 2)),
+                                      _mm_add_epi32(_mm_srli_epi32(c, 2), _mm_srli_epi32(d, 2)));
+  auto const rest =
+      _mm_add_epi32(_mm_add_epi32(_mm_and_si128(a, low), _mm_and_si128(b, low)),
+                    _mm_add_epi32(_mm_and_si128(c, low),
+                                  _mm_add_epi32(_mm_and_si128(d, low), _mm_set1_epi32(2))));
+
+  return _mm_add_epi32(quarters, _mm_srli_epi32(rest, 2));
+}
+
+// Even and odd pixels of eight in a row, each four in order //
+template <i32 lanes>
+[[nodiscard]] auto pick(__m128i const lo, __m128i const hi) noexcept -> __m128i {
+  return _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), lanes));
+}
+
+} // namespace
+
+auto downsample_rows(n32 const* const a, n32 const* const b, n32 const width,
+                     n32* const dst) noexcept -> void {
+  auto constexpr step = 2 * sizeof(__m128i) / sizeof(n32);
+  auto constexpr even = _MM_SHUFFLE(2, 0, 2, 0);
+  auto constexpr odd = _MM_SHUFFLE(3, 1, 3, 1);
+
+  // Baseline SSE2 runs on every CPU, and four adds per pixel leave it bound by memory anyway //
+  auto x = 0U;
+  for (; x + step <= width; x += step) {
+    auto const a0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&a[x]));
+    auto const a1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&a[x + 4U]));
+    auto const b0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&b[x]));
+    auto const b1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&b[x + 4U]));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[x / 2U]),
+                     mean4(pick<even>(a0, a1), pick<odd>(a0, a1), pick<even>(b0, b1),
+                           pick<odd>(b0, b1)));
+  }
+
+  for (; x < width; x += 2U) {
+    auto const right = std::min(x + 1U, width - 1U);
+    dst[x / 2U] = mean4(a[x], a[right], b[x], b[right]);
+  }
+}
+
+Pyramid::Pyramid(std::string_view const filename, n32 const width, n32 const height,
+                 n32 const maxiter, Format const format) noexcept
+    : maxiter_{maxiter}, format_{format} {
+  auto path = std::filesystem::path{filename};
+  path.replace_extension();
+
+  descriptor_ = path.string() + ".dzi";
+  files_ = path.string() + "_files";
+
+  for (auto w = width, h = height;; w = (w + 1U) / 2U, h = (h + 1U) / 2U) {
+    levels_.push_back({.width = w, .height = h, .rows = 0U, .strip = {}});
+    if (w == 1U && h == 1U)
+      break;
+  }
+
+  std::ranges::reverse(levels_);
+
+  // Failing here shows as failing to write a tile //
+  auto ec = std::error_code{};
+
+  for (auto i = Size{}; i < levels_.size(); ++i) {
+    auto& level = levels_[i];
+    level.strip.resize(Size{pyramid_tile_pixels} * level.width);
+    std::filesystem::create_directories(fmt::format("{}/{}", files_, i), ec);
+  }
+
+  tile_.resize(Size{pyramid_tile_pixels} * pyramid_tile_pixels);
+}
+
+auto Pyramid::add_rows(n32 const* rows, n32 const count) noexcept -> bool {
+  auto const top = static_cast<n32>(levels_.size() - 1U);
+  auto& level = levels_.back();
+  auto ok = true;
+
+  for (auto i = 0U; i < count; ++i, rows += level.width) {
+    std::copy_n(rows, level.width, next_row_(level));
+    ok = add_row_(top) && ok;
+  }
+
+  return ok;
+}
+
+auto Pyramid::finish() const noexcept -> bool {
+  auto fp = std::fopen(descriptor_.c_str(), "w");
+
+  if (!fp)
+    return false;
+
+  auto const& frame = levels_.back();
+  fmt::print(fp,
+             "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+             "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"{}\" "
+             "Overlap=\"0\" TileSize=\"{}\">\n"
+             "  <Size Width=\"{}\" Height=\"{}\"/>\n"
+             "</Image>\n",
+             extension(format_), pyramid_tile_pixels, frame.width, frame.height);
+
+  return std::fclose(fp) == 0;
+}
+
+auto Pyramid::next_row_(Level& level) const noexcept -> n32* {
+  return &level.strip[Size{level.rows % pyramid_tile_pixels} * level.width];
+}
+
+auto Pyramid::add_row_(n32 const index) noexcept -> bool {
+  auto& level = levels_[index];
+  auto const* const row = next_row_(level);
+  auto ok = true;
+
+  ++level.rows;
+
+  // A pair of rows is averaged while both are still in cache; a last odd row pairs with itself //
+  if (index > 0U && (level.rows % 2U == 0U || level.rows == level.height)) {
+    auto const* const above = level.rows % 2U == 0U ? row - level.width : row;
+    downsample_rows(above, row, level.width, next_row_(levels_[index - 1U]));
+    ok = add_row_(index - 1U);
+  }
+
+  if (level.rows % pyramid_tile_pixels == 0U || level.rows == level.height)
+    ok = write_strip_(index) && ok;
+
+  return ok;
+}
+
+auto Pyramid::write_strip_(n32 const index) noexcept -> bool {
+  auto const& level = levels_[index];
+  auto const row = (level.rows - 1U) / pyramid_tile_pixels;
+  auto const height = level.rows - row * pyramid_tile_pixels;
+  auto ok = true;
+
+  for (auto x = 0U; x < level.width; x += pyramid_tile_pixels) {
+    auto const width = std::min(pyramid_tile_pixels, level.width - x);
+
+    for (auto y = 0U; y < height; ++y)
+      std::copy_n(&level.strip[Size{y} * level.width + x], width, &tile_[Size{y} * width]);
+
+    auto const path = fmt::format("{}/{}/{}_{}.{}", files_, index, x / pyramid_tile_pixels, row,
+                                  extension(format_));
+    ok = write_tile_(path, tile_.data(), width, height) && ok;
+    ++tile_count_;
+  }
+
+  return ok;
+}
+
+auto Pyramid::write_tile_(std::string const& path, n32 const* const pixels, n32 const width,
+                          n32 const height) const noexcept -> bool {
+  auto fp = std::fopen(path.c_str(), format_ == Format::Ascii ? "w" : "wb");
+
+  if (!fp)
+    return false;
+
+  auto ok = true;
+
+  if (format_ == Format::Png) {
+    auto strips = std::vector<PngStrip>{};
+
+    for (auto y = 0U; ok && y < height; y += png_strip_rows) {
+      auto const rows = std::min(png_strip_rows, height - y);
+      auto const& strip = strips.emplace_back(
+          encode_png_strip(&pixels[Size{y} * width],
+                           y == 0U ? nullptr : &pixels[Size{y - 1U} * width], width, rows,
+                           maxiter_, y + rows == height));
+      ok = !strip.data.empty();
+    }
+
+    ok = ok && write_png(fp, width, height, maxiter_, strips);
+  } else
+    ok = write_header(fp, format_, width, height, maxiter_) &&
+         write_samples(fp, format_, pixels, Size{width} * height, width, maxiter_);
+
+  return std::fclose(fp) == 0 && ok;
+}
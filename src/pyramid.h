@@ -0,0 +1,71 @@
+#pragma once
+
+#include "output.h"
+#include "util.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Pixels along either side of a tile of a pyramid; the tiles at the right and bottom edges of a
+// level are cut short by it
+auto constexpr inline pyramid_tile_pixels = 256U;
+
+// Averages rows a and b of width pixels into dst, a row of (width + 1) / 2 pixels, each the mean
+// of 2x2 pixels rounded to nearest; a last odd pixel is the mean of the two it has
+auto downsample_rows(n32 const* a, n32 const* b, n32 width, n32* dst) noexcept -> void;
+
+// Writes a frame as a Deep Zoom image while its rows arrive, without keeping or reading it again:
+// NAME.dzi describes the image and NAME_files/LEVEL/COL_ROW.EXT hold the tiles of every level,
+// from level 0 of a single pixel up to the frame itself, each level halving the one above it,
+// rounded up. Every pair of rows of a level is averaged into a row of the level below as soon as
+// it arrives, and a strip of tiles is written as soon as a level has all of its rows, so only one
+// strip of tiles per level is kept in memory
+class Pyramid {
+public:
+  // NAME is filename with its extension taken off //
+  Pyramid(std::string_view filename, n32 width, n32 height, n32 maxiter, Format format) noexcept;
+
+  // Takes the next count rows of the frame; returns whether every tile they finished was written //
+  auto add_rows(n32 const* rows, n32 count) noexcept -> bool;
+
+  // Writes the description, once every row has been added; returns whether it was written //
+  auto finish() const noexcept -> bool;
+
+  [[nodiscard, gnu::cold]] auto level_count() const noexcept {
+    return static_cast<n32>(levels_.size());
+  }
+
+  [[nodiscard, gnu::cold]] auto tile_count() const noexcept { return tile_count_; }
+
+private:
+  struct Level {
+    n32 width, height;
+    // Of the level, so far //
+    n32 rows = 0U;
+    // The rows of the strip of tiles being filled //
+    std::vector<n32> strip;
+  };
+
+  // Where the next row of a level goes //
+  [[nodiscard]] auto next_row_(Level& level) const noexcept -> n32*;
+
+  // Takes in the row just put where next_row_() said, passing it down the levels below //
+  auto add_row_(n32 level) noexcept -> bool;
+
+  // Writes the tiles of the strip of a level, the rows of which are all there //
+  auto write_strip_(n32 level) noexcept -> bool;
+
+  auto write_tile_(std::string const& path, n32 const* pixels, n32 width,
+                   n32 height) const noexcept -> bool;
+
+  std::string descriptor_;
+  std::string files_;
+  n32 maxiter_;
+  Format format_;
+  // Level 0 first //
+  std::vector<Level> levels_;
+  // Holds a tile while it is written //
+  std::vector<n32> tile_;
+  n64 tile_count_ = 0U;
+};
@@ -0,0 +1,491 @@
+#include "renderer.h"
+#include "shard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <utility>
+
+Renderer::Renderer(n32 const thread_count) noexcept {
+  // hardware_concurrency() may not know, in which case the caller still gets a worker //
+  auto const count = std::max(thread_count, 1U);
+
+  preview_image_.quiet_ = true;
+  batch_tiles_ = std::make_unique<Scheduler[]>(count);
+
+  workers_.reserve(count);
+  for (auto i = 0U; i < count; ++i)
+    workers_.emplace_back([this, i](std::stop_token const& stop) { work_(i, stop); });
+}
+
+Renderer::~Renderer() noexcept {
+  for (auto& worker : workers_)
+    worker.request_stop();
+
+  generation_.fetch_add(1U, std::memory_order_release);
+  generation_.notify_all();
+}
+
+auto Renderer::render(Image::Args const& args, Image& image, n32* const target) noexcept
+    -> void {
+  image.reset_(args);
+  preview_(image);
+  render_band_(image, {.begin = 0U, .end = image.resolution_.y}, target);
+}
+
+auto Renderer::render_reusing(Image::Args const& args, Image& image, Image const& previous,
+                              f64 const tolerance) noexcept -> void {
+  image.reset_(args);
+
+  auto const& res = image.resolution_;
+  auto const perturbed = image.precision_ == Image::Precision::Perturb ||
+                         previous.precision_ == Image::Precision::Perturb;
+
+  if (!perturbed && previous.resolution_.x == res.x && previous.resolution_.y == res.y &&
+      previous.band_.rows() == res.y) {
+    image.previous_ = &previous;
+    image.reuse_tolerance_ = tolerance;
+    image.subdivide_ = false;
+  }
+
+  preview_(image);
+  render_band_(image, {.begin = 0U, .end = res.y});
+
+  image.previous_ = nullptr;
+}
+
+auto Renderer::render_batch(std::span<Image::Args const> const args,
+                            std::span<Image> const images) noexcept -> void {
+  batch_.clear();
+
+  for (auto i = Size{}; i < args.size(); ++i) {
+    auto& image = images[i];
+    image.quiet_ = true;
+    image.reset_(args[i]);
+
+    auto const& res = image.resolution_;
+    auto const full = Image::Band{.begin = 0U, .end = res.y};
+
+    if (Size{res.x} * res.y > batch_pixels) {
+      preview_(image);
+      render_band_(image, full);
+      continue;
+    }
+
+    // Buffers are set up here, so that the workers only render //
+    image.select_(full);
+
+    if (image.stats_) {
+      image.worker_stats_.assign(1U, {});
+      image.started_ = std::chrono::steady_clock::now();
+    }
+
+    if (image.heatmap_)
+      image.heatmap_->add_workers(1U);
+
+    batch_.push_back(&image);
+  }
+
+  auto next = std::atomic<Size>{0U};
+
+  launch_([&](n32 const worker) {
+    auto& tiles = batch_tiles_[worker];
+
+    for (auto i = next.fetch_add(1U, std::memory_order_relaxed); i < batch_.size();
+         i = next.fetch_add(1U, std::memory_order_relaxed)) {
+      auto& image = *batch_[i];
+      auto const tile = image.subdivide_ ? Scheduler::subdivision_tile_size : Scheduler::tile_size;
+
+      tiles.reset(image.computed_, tile, 1U);
+      image.work_(tiles, 0U);
+    }
+  });
+  finish_();
+
+  for (auto* const image : batch_)
+    if (image->stats_)
+      image->settle_stats_();
+
+  for (auto& image : images.first(args.size()))
+    image.quiet_ = false;
+}
+
+auto Renderer::render_zoom(std::span<Keyframe const> const keys, Image::Args const& base,
+                           std::optional<f64> const reuse, Image& image,
+                           FrameSink const& sink) noexcept -> bool {
+  auto const first = keys.front().frame;
+  auto const last = keys.back().frame;
+
+  auto ok = true;
+  auto writer = std::jthread{};
+
+  image.quiet_ = true;
+  zoom_spare_.quiet_ = true;
+
+  for (auto frame = first; frame <= last; ++frame) {
+    auto& img = (frame - first) % 2U == 0U ? image : zoom_spare_;
+    auto const& previous = (frame - first) % 2U == 0U ? zoom_spare_ : image;
+    auto const args = zoom_args(keys, frame, base);
+
+    // The writer only ever reads the frame before, which this one only reads as well //
+    if (reuse && frame != first)
+      render_reusing(args, img, previous, *reuse);
+    else
+      render(args, img);
+
+    if (writer.joinable())
+      writer.join();
+
+    // Joining hands ok back and forth, so it needs no synchronisation of its own //
+    writer = std::jthread{[&, &img = img, frame] { ok = ok && sink(img, frame); }};
+  }
+
+  if (writer.joinable())
+    writer.join();
+
+  if ((last - first) % 2U == 1U)
+    std::swap(image, zoom_spare_);
+
+  image.quiet_ = false;
+  return ok;
+}
+
+auto Renderer::render_streamed(Image::Args const& args, Image& image,
+                               RowSink const& sink) noexcept -> bool {
+  image.reset_(args);
+  preview_(image);
+  start_(image, {.begin = 0U, .end = image.resolution_.y}, nullptr, true);
+
+  auto const& res = image.resolution_;
+  auto ok = true;
+
+  for (auto written = 0U; written < res.y;) {
+    // Read before the rows are checked, so that a row finishing in between still wakes us //
+    auto const progress = tiles_.progress();
+
+    auto ready = written;
+    while (ready < res.y && tiles_.rendered(image.source_row_(ready)))
+      ++ready;
+
+    if (ready == written) {
+      tiles_.wait(progress);
+      continue;
+    }
+
+    // A failed sink stops the handing out, but the render still has to run its course //
+    ok = ok && sink(image.row_(written), ready - written);
+    written = ready;
+  }
+
+  finish_();
+
+  if (image.stats_)
+    image.settle_stats_();
+
+  return ok;
+}
+
+auto Renderer::render_streamed(Image::Args const& args, Image& image, std::FILE* const fp,
+                               Format const format) noexcept -> bool {
+  auto const& res = args.resolution;
+  auto const header = write_header(fp, format, res.x, res.y, args.maxiter);
+
+  return render_streamed(args, image,
+                         [&](n32 const* const rows, n32 const count) {
+                           return header && write_samples(fp, format, rows, Size{count} * res.x,
+                                                          res.x, args.maxiter);
+                         }) &&
+         header;
+}
+
+auto Renderer::render_banded(Image::Args const& args, Image& image, std::FILE* const fp,
+                             Format const format, Size const budget) noexcept -> bool {
+  image.reset_(args);
+  preview_(image);
+
+  auto const& res = image.resolution_;
+
+  // One band renders while the one before it is written, so two of them share the budget //
+  auto const row_bytes = Size{res.x} * sizeof(n32);
+  auto rows = static_cast<n32>(std::clamp<Size>(budget / (2U * row_bytes), 1U, res.y));
+
+  // Whole rows of tiles per band lay tiles out as in a single pass, which subdivision depends on //
+  auto const tile_rows =
+      image.subdivide_ ? Scheduler::subdivision_tile_size.y : Scheduler::tile_size.y;
+  if (rows > tile_rows)
+    rows -= rows % tile_rows;
+
+  auto spare = decltype(image.data_){nullptr, image.data_.get_deleter()};
+  auto spare_capacity = Size{0U};
+  auto ok = write_header(fp, format, res.x, res.y, image.maxiter_);
+  auto writer = std::jthread{};
+
+  for (auto begin = 0U; begin < res.y; begin += rows) {
+    render_band_(image, {.begin = begin, .end = std::min(begin + rows, res.y)});
+
+    // The previous band must be out before its buffer takes this one's place //
+    if (writer.joinable())
+      writer.join();
+
+    std::swap(image.data_, spare);
+    std::swap(image.capacity_, spare_capacity);
+
+    // Joining hands ok back and forth, so it needs no synchronisation of its own //
+    writer = std::jthread{[&, count = image.pixel_count_, src = spare.get()] {
+      ok = ok && write_samples(fp, format, src, count, res.x, image.maxiter_);
+    }};
+  }
+
+  if (writer.joinable())
+    writer.join();
+
+  // Leave the last band where the caller can see it //
+  std::swap(image.data_, spare);
+  std::swap(image.capacity_, spare_capacity);
+  image.pixels_ = image.data_.get();
+
+  return ok;
+}
+
+auto Renderer::render_shard(Image::Args const& args, Image& image, Image::Band const rows,
+                            std::FILE* const fp) noexcept -> bool {
+  image.reset_(args);
+  preview_(image);
+
+  auto const& res = image.resolution_;
+  auto const whole = image.computed_rows_({.begin = 0U, .end = res.y}, image.axis_);
+  auto const source = [&](n32 const y) {
+    return y >= whole.begin && y < whole.end ? y : *image.axis_ - y;
+  };
+
+  auto band = Image::Band{.begin = res.y, .end = 0U};
+  for (auto y = rows.begin; y < rows.end; ++y) {
+    band.begin = std::min(band.begin, source(y));
+    band.end = std::max(band.end, source(y) + 1U);
+  }
+
+  // Widened to whole rows of the tiles render() lays out from the first row it computes, which
+  // only stay the same tiles when cut off by the same last row
+  auto const tile_rows =
+      image.subdivide_ ? Scheduler::subdivision_tile_size.y : Scheduler::tile_size.y;
+  band.begin -= (band.begin - whole.begin) % tile_rows;
+  band.end = std::min(whole.end, band.end + (tile_rows - (band.end - whole.begin) % tile_rows) %
+                                                tile_rows);
+
+  render_band_(image, band);
+
+  auto ok = write_shard_header(fp, {.width = res.x,
+                                    .height = res.y,
+                                    .rows = rows,
+                                    .maxiter = image.maxiter_,
+                                    .view = view_fingerprint(args),
+                                    .isa = image.isa_});
+
+  // Mirrored rows run backwards through the band, so rows are written one at a time //
+  for (auto y = rows.begin; ok && y < rows.end; ++y)
+    ok = write_samples(fp, Format::Raw, image.row_(source(y)), res.x, res.x, image.maxiter_);
+
+  return ok;
+}
+
+auto Renderer::render_progressive(Image::Args const& args, Image& image,
+                                  Progress const& progress, std::stop_token stop,
+                                  std::optional<Scheduler::Deadline> const deadline) noexcept
+    -> n32 {
+  // Tiles must start on the grid of every pass, which are refined by halving //
+  static_assert(Scheduler::tile_size.x % progressive_strides.front() == 0U);
+  static_assert(std::ranges::adjacent_find(progressive_strides, [](n32 const a, n32 const b) {
+                  return a != 2U * b;
+                }) == progressive_strides.end());
+
+  image.reset_(args);
+  image.subdivide_ = false;
+  preview_(image);
+
+  auto const full = Image::Band{.begin = 0U, .end = image.resolution_.y};
+  auto const single = image.precision_ == Image::Precision::Perturb;
+  auto passes = 0U;
+  auto coarser = 0U;
+
+  tiles_.limit(std::move(stop), deadline);
+
+  for (auto const stride : progressive_strides) {
+    if (single && stride != 1U)
+      continue;
+
+    image.pass_ = {.stride = stride, .coarser = coarser};
+    coarser = stride;
+
+    render_band_(image, full);
+
+    if (tiles_.cancelled())
+      break;
+
+    if (stride != 1U) {
+      auto next = std::atomic<n32>{0U};
+
+      launch_([&](n32) {
+        for (auto y = next.fetch_add(1U, std::memory_order_relaxed); y < full.end;
+             y = next.fetch_add(1U, std::memory_order_relaxed))
+          image.fill_row_(y);
+      });
+      finish_();
+    }
+
+    progress(image, passes++);
+  }
+
+  tiles_.limit({}, std::nullopt);
+  image.pass_ = {};
+
+  return passes;
+}
+
+auto Renderer::save_png(Image const& image, std::FILE* const fp) noexcept -> bool {
+  auto const& res = image.resolution_;
+  auto const band = image.band_;
+  auto const count = (band.rows() + png_strip_rows - 1U) / png_strip_rows;
+  auto const format = image.color_ ? Format::PngRgba : Format::Png;
+
+  auto strips = std::vector<PngStrip>(count);
+  auto next = std::atomic<n32>{0U};
+
+  launch_([&](n32) {
+    for (auto i = next.fetch_add(1U, std::memory_order_relaxed); i < count;
+         i = next.fetch_add(1U, std::memory_order_relaxed)) {
+      auto const y = band.begin + i * png_strip_rows;
+
+      strips[i] = encode_png_strip(image.row_(y), i == 0U ? nullptr : image.row_(y - 1U), res.x,
+                                   std::min(png_strip_rows, band.end - y), image.maxiter_,
+                                   i + 1U == count, format);
+    }
+  });
+  finish_();
+
+  return write_png(fp, res.x, band.rows(), image.maxiter_, strips, format);
+}
+
+auto Renderer::render_band_(Image& image, Image::Band const band, n32* const target) noexcept
+    -> void {
+  start_(image, band, target, false);
+  finish_();
+
+  if (image.stats_)
+    image.settle_stats_();
+}
+
+auto Renderer::start_(Image& image, Image::Band const band, n32* const target,
+                      bool const in_order) noexcept -> void {
+  image.select_(band, target);
+
+  // Counters add up over the bands of a render //
+  if (image.stats_) {
+    image.worker_stats_.resize(thread_count());
+    image.started_ = std::chrono::steady_clock::now();
+  }
+
+  if (image.heatmap_)
+    image.heatmap_->add_workers(thread_count());
+
+  auto const tile = image.subdivide_ ? Scheduler::subdivision_tile_size : Scheduler::tile_size;
+  tiles_.reset(image.computed_, tile, thread_count(), in_order, rank_tiles_(image, tile));
+
+  launch_([this, &image](n32 const worker) { image.work_(tiles_, worker); });
+}
+
+auto Renderer::launch_(std::function<void(n32 worker)> task) noexcept -> void {
+  task_ = std::move(task);
+  busy_.store(thread_count(), std::memory_order_relaxed);
+
+  generation_.fetch_add(1U, std::memory_order_release);
+  generation_.notify_all();
+}
+
+auto Renderer::finish_() noexcept -> void {
+  for (auto busy = busy_.load(std::memory_order_acquire); busy != 0U;
+       busy = busy_.load(std::memory_order_acquire))
+    busy_.wait(busy, std::memory_order_acquire);
+
+  task_ = nullptr;
+}
+
+auto Renderer::work_(n32 const worker, std::stop_token const& stop) noexcept -> void {
+  auto seen = 0U;
+
+  for (;;) {
+    generation_.wait(seen, std::memory_order_acquire);
+    seen = generation_.load(std::memory_order_acquire);
+
+    if (stop.stop_requested())
+      return;
+
+    task_(worker);
+
+    if (busy_.fetch_sub(1U, std::memory_order_acq_rel) == 1U)
+      busy_.notify_one();
+  }
+}
+
+auto Renderer::preview_(Image const& image) noexcept -> void {
+  if (!image.predict_)
+    return;
+
+  // The same kernels on the same frame, only coarser; rows stay a whole number of vectors //
+  auto const width = isa_width(image.isa_);
+  auto const& res = image.resolution_;
+  auto const x = (res.x + preview_scale - 1U) / preview_scale;
+
+  auto const args = Image::Args{
+      .resolution = {.x = (x + width - 1U) / width * width,
+                     .y = (res.y + preview_scale - 1U) / preview_scale},
+      .frame = image.frame_,
+      .maxiter = image.maxiter_,
+      .kernel = image.kernel_,
+      .interior = image.interior_,
+      .precision = image.precision_,
+      .isa = image.isa_,
+  };
+
+  preview_image_.reset_(args);
+  render_band_(preview_image_, {.begin = 0U, .end = args.resolution.y});
+}
+
+auto Renderer::rank_tiles_(Image const& image, Image::Coord const tile) noexcept
+    -> std::span<n32 const> {
+  if (!image.predict_)
+    return {};
+
+  auto const& area = image.computed_;
+  auto const grid = Image::Coord{(area.width() + tile.x - 1U) / tile.x,
+                                 (area.height() + tile.y - 1U) / tile.y};
+
+  tile_costs_.assign(Size{grid.x} * grid.y, 0U);
+
+  // Every preview pixel stands for the pixels around its centre, and its iteration count for
+  // what each of them costs
+  auto const& res = image.resolution_;
+  auto const& preview = preview_image_.resolution_;
+
+  for (auto py = 0U; py < preview.y; ++py) {
+    auto const y = static_cast<n32>((Size{py} * 2U + 1U) * res.y / (Size{preview.y} * 2U));
+
+    if (y < area.lower.y || y >= area.upper.y)
+      continue;
+
+    auto const* const row = preview_image_.row_(py);
+    auto* const costs = &tile_costs_[Size{(y - area.lower.y) / tile.y} * grid.x];
+
+    for (auto px = 0U; px < preview.x; ++px) {
+      auto const x = static_cast<n32>((Size{px} * 2U + 1U) * res.x / (Size{preview.x} * 2U));
+      costs[x / tile.x] += row[px];
+    }
+  }
+
+  ranking_.resize(tile_costs_.size());
+  std::iota(ranking_.begin(), ranking_.end(), 0U);
+  std::ranges::stable_sort(ranking_, [this](n32 const a, n32 const b) {
+    return tile_costs_[a] > tile_costs_[b];
+  });
+
+  return ranking_;
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "animation.h"
+#include "image.h"
+#include "output.h"
+#include "scheduler.h"
+#include "util.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+// Long-lived pool of workers rendering into images owned by the caller, so that a batch of frames
+// pays for its threads once and for buffers only when the resolution grows. Renders from several
+// threads at once must be serialised by the caller
+class Renderer {
+public:
+  explicit Renderer(n32 thread_count = std::jthread::hardware_concurrency()) noexcept;
+
+  Renderer(Renderer const&) = delete;
+  Renderer(Renderer&&) = delete;
+
+  auto operator=(Renderer const&) -> Renderer& = delete;
+  auto operator=(Renderer&&) -> Renderer& = delete;
+
+  ~Renderer() noexcept;
+
+  // Blocks until image holds the frame described by args; args.thread_count is not used. Given a
+  // target, which must be 64-byte aligned and hold every pixel, the frame is rendered there in
+  // place of image's own buffer, and image.data() points into it until the next render
+  auto render(Image::Args const& args, Image& image, n32* target = nullptr) noexcept -> void;
+
+  // Renders like render(), but takes every pixel that lands within tolerance (in pixels) of one of
+  // previous's from it instead of computing it, as long as its neighbours in previous all count
+  // the same; previous must be a whole frame of the same resolution, such as the one before in an
+  // animation. Subdivision is not used, and perturbed frames on either side are rendered in full
+  auto render_reusing(Image::Args const& args, Image& image, Image const& previous,
+                      f64 tolerance) noexcept -> void;
+
+  // Frames of at most this many pixels are rendered by a single worker when batched, as they are
+  // done sooner than waking the others and waiting for them would take
+  auto constexpr static batch_pixels = Size{256U} * 256U;
+
+  // Renders every frame of args into the image of the same index, as render() would but without
+  // printing timings. Large frames are rendered one after the other on every worker; small ones,
+  // see batch_pixels, side by side, each by a worker of its own, so that a batch of them keeps
+  // every worker busy. Small frames are not predicted
+  auto render_batch(std::span<Image::Args const> args, std::span<Image> images) noexcept -> void;
+
+  // Called with every frame of a zoom and its number, in order and on a thread of its own while
+  // the next frame renders; returns whether the frame was written
+  using FrameSink = std::function<bool(Image const& frame, n32 number)>;
+
+  // Renders the frames from the first keyframe to the last, each the view zoom_args() gives it,
+  // handing every frame to sink while the next one renders. With reuse, every frame after the
+  // first takes the pixels within reuse pixels of one of the frame before's from it, as
+  // render_reusing() does. image holds the last frame afterwards; returns whether sink succeeded
+  // for every frame, after the first failure of which it is not called again
+  auto render_zoom(std::span<Keyframe const> keys, Image::Args const& base,
+                   std::optional<f64> reuse, Image& image, FrameSink const& sink) noexcept -> bool;
+
+  // Called with the image after every pass of a progressive render, and the number of the pass //
+  using Progress = std::function<void(Image const& image, n32 pass)>;
+
+  // Pixel strides of the passes of a progressive render: every 4th pixel each way, then the rest
+  // of every 2nd, then the rest of them all
+  auto constexpr static progressive_strides = std::array{4U, 2U, 1U};
+
+  // Renders the frame coarse to fine in the passes of progressive_strides, each computing only the
+  // pixels the passes before it have not. After each, the pixels left out are filled in from
+  // their computed neighbours and progress is called. Once stop is requested or the deadline
+  // passes, workers take no more tiles and the render returns as soon as the tiles they are on
+  // are done. Returns how many passes were completed; image holds the last of them, refined in
+  // places by the one cut short. Subdivision is not used, and perturbed frames take one pass
+  auto render_progressive(Image::Args const& args, Image& image, Progress const& progress,
+                          std::stop_token stop = {},
+                          std::optional<Scheduler::Deadline> deadline = std::nullopt) noexcept
+      -> n32;
+
+  // Called with rows of a frame in order, count of them starting at rows, each as soon as it and
+  // every row above it are done; returns whether they were taken in
+  using RowSink = std::function<bool(n32 const* rows, n32 count)>;
+
+  // Hands the frame to sink as it renders, so that whatever sink does with the rows overlaps
+  // computation; returns whether sink succeeded for every row, after the first failure of which
+  // it is not called again
+  auto render_streamed(Image::Args const& args, Image& image, RowSink const& sink) noexcept
+      -> bool;
+
+  // Writes the frame to fp as it renders, as render_streamed() above hands it out; returns
+  // whether every write succeeded
+  auto render_streamed(Image::Args const& args, Image& image, std::FILE* fp,
+                       Format format) noexcept -> bool;
+
+  // Writes image as a PNG, of its colours if it was rendered in colour, its strips deflated in
+  // parallel by the workers; returns whether every write succeeded
+  auto save_png(Image const& image, std::FILE* fp) noexcept -> bool;
+
+  // Streams the frame to fp in bands of rows, each written while the next one renders, so that
+  // the pixel buffers stay within budget bytes whatever the resolution. image holds the last band
+  // afterwards; returns whether every write succeeded
+  auto render_banded(Image::Args const& args, Image& image, std::FILE* fp, Format format,
+                     Size budget) noexcept -> bool;
+
+  // Renders rows of the frame exactly as render() renders them as part of the whole frame and
+  // writes them to fp as a shard file, see ShardHeader, so that the shards of several processes
+  // merge into the image a single one renders. Rows that render() mirrors are taken from the rows
+  // they mirror, and tiles are laid out as for the whole frame, which subdivision depends on.
+  // image holds the rows the shard's are taken from afterwards; returns whether every write
+  // succeeded
+  auto render_shard(Image::Args const& args, Image& image, Image::Band rows,
+                    std::FILE* fp) noexcept -> bool;
+
+  // Previews for predicting tile costs are rendered at this fraction of the resolution //
+  auto constexpr static preview_scale = 8U;
+
+  [[nodiscard, gnu::cold]] auto thread_count() const noexcept {
+    return static_cast<n32>(workers_.size());
+  }
+
+private:
+  // Renders the rows of band of the view image was last reset to, into target if given //
+  auto render_band_(Image& image, Image::Band band, n32* target = nullptr) noexcept -> void;
+
+  // Renders the preview of image's view that its tiles are ranked by, if it predicts their costs //
+  auto preview_(Image const& image) noexcept -> void;
+
+  // The tile indices of area, cut into tiles of the given size, costliest first as estimated from
+  // the preview; empty if image does not predict costs
+  [[nodiscard]] auto rank_tiles_(Image const& image, Image::Coord tile) noexcept
+      -> std::span<n32 const>;
+
+  // Wakes the workers on a band //
+  auto start_(Image& image, Image::Band band, n32* target, bool in_order) noexcept -> void;
+
+  // Every worker runs task once; finish_() waits for them all to return from it //
+  auto launch_(std::function<void(n32 worker)> task) noexcept -> void;
+  auto finish_() noexcept -> void;
+
+  auto work_(n32 worker, std::stop_token const& stop) noexcept -> void;
+
+  // Bumped for every render and on shutdown; idle workers sleep on it //
+  std::atomic<n32> generation_ = 0U;
+  // Workers yet to finish the current render, which render() sleeps on //
+  std::atomic<n32> busy_ = 0U;
+  std::function<void(n32 worker)> task_;
+  Scheduler tiles_;
+  // One per worker, for the frames of a batch that it renders on its own //
+  std::unique_ptr<Scheduler[]> batch_tiles_;
+  std::vector<Image*> batch_;
+
+  Image preview_image_;
+  // Holds every other frame of a zoom //
+  Image zoom_spare_;
+  std::vector<n64> tile_costs_;
+  std::vector<n32> ranking_;
+
+  // Last, so the workers are joined before anything they use is destroyed //
+  std::vector<std::jthread> workers_;
+};
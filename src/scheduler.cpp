@@ -0,0 +1,182 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+[[nodiscard]] auto constexpr pack(n32 const begin, n32 const end) noexcept -> n64 {
+  return n64{begin} | (n64{end} << 32U);
+}
+
+[[nodiscard]] auto constexpr unpack(n64 const range) noexcept -> std::pair<n32, n32> {
+  return {static_cast<n32>(range), static_cast<n32>(range >> 32U)};
+}
+
+} // namespace
+
+auto Scheduler::reset(Image::Rect const& area, Image::Coord const tile, n32 const workers,
+                      bool const in_order, std::span<n32 const> const ranking) noexcept -> void {
+  area_ = area;
+  tile_ = tile;
+  grid_ = {(area.width() + tile.x - 1U) / tile.x, (area.height() + tile.y - 1U) / tile.y};
+  worker_count_ = workers;
+  in_order_ = in_order;
+
+  if (workers > capacity_) {
+    deques_ = std::make_unique<Deque[]>(workers);
+    capacity_ = workers;
+  }
+
+  if (grid_.y > row_capacity_) {
+    pending_ = std::make_unique<std::atomic<n32>[]>(grid_.y);
+    row_capacity_ = grid_.y;
+  }
+
+  for (auto i = 0U; i < grid_.y; ++i)
+    pending_[i].store(grid_.x, std::memory_order_relaxed);
+
+  finished_.store(0U, std::memory_order_relaxed);
+  cancelled_.store(false, std::memory_order_relaxed);
+  ranked_.clear();
+
+  // Worker i gets the tiles ranked i, i + workers, ..., the first few one more than the rest //
+  if (!ranking.empty()) {
+    auto const count = grid_.x * grid_.y;
+    auto const per = count / workers;
+    auto const extra = count % workers;
+
+    ranked_.resize(count);
+
+    for (auto i = 0U; i < workers; ++i) {
+      auto const begin = i * per + std::min(i, extra);
+      auto const end = (i + 1U) * per + std::min(i + 1U, extra);
+
+      for (auto slot = begin; slot < end; ++slot)
+        ranked_[slot] = ranking[(slot - begin) * workers + i];
+
+      deques_[i].range.store(pack(begin, end), std::memory_order_relaxed);
+    }
+
+    return;
+  }
+
+  // Slots are numbered row by row, so every worker starts out on a band of its own; dealt in
+  // order, worker i has rows of tiles i, i + workers, ... in its band, the first few getting one
+  // row more than the rest
+  auto const count = n64{grid_.x} * grid_.y;
+  auto const rows_per = grid_.y / workers;
+  auto const extra = grid_.y % workers;
+
+  for (auto i = 0U; i < workers; ++i) {
+    auto const begin = in_order ? n64{grid_.x} * (i * rows_per + std::min(i, extra))
+                                : count * i / workers;
+    auto const end = in_order ? n64{grid_.x} * ((i + 1U) * rows_per + std::min(i + 1U, extra))
+                              : count * (i + 1U) / workers;
+
+    deques_[i].range.store(pack(static_cast<n32>(begin), static_cast<n32>(end)),
+                           std::memory_order_relaxed);
+  }
+}
+
+auto Scheduler::limit(std::stop_token stop, std::optional<Deadline> const deadline) noexcept
+    -> void {
+  limited_ = stop.stop_possible() || deadline;
+  stop_ = std::move(stop);
+  deadline_ = deadline;
+}
+
+auto Scheduler::next(n32 const worker) noexcept -> std::optional<Tile> {
+  if (limited_ && (stop_.stop_requested() ||
+                   (deadline_ && std::chrono::steady_clock::now() >= *deadline_))) [[unlikely]] {
+    cancelled_.store(true, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+
+  auto idx = pop_(worker);
+
+  if (!idx) [[unlikely]]
+    idx = steal_(worker);
+
+  if (!idx)
+    return std::nullopt;
+
+  auto const tile = tile_index_(*idx);
+  auto const lower = Image::Coord{area_.lower.x + tile % grid_.x * tile_.x,
+                                  area_.lower.y + tile / grid_.x * tile_.y};
+
+  return Tile{.lower = lower,
+              .upper = {std::min(lower.x + tile_.x, area_.upper.x),
+                        std::min(lower.y + tile_.y, area_.upper.y)}};
+}
+
+auto Scheduler::done(Tile const& tile) noexcept -> void {
+  auto const row = (tile.lower.y - area_.lower.y) / tile_.y;
+
+  if (pending_[row].fetch_sub(1U, std::memory_order_acq_rel) == 1U) {
+    finished_.fetch_add(1U, std::memory_order_release);
+    finished_.notify_all();
+  }
+}
+
+auto Scheduler::tile_index_(n32 const slot) const noexcept -> n32 {
+  if (!ranked_.empty())
+    return ranked_[slot];
+
+  if (!in_order_)
+    return slot;
+
+  // Inverts the dealing in reset(): the bands of the first extra workers are rows_per + 1 rows
+  // of tiles long, the rest rows_per
+  auto const rows_per = grid_.y / worker_count_;
+  auto const extra = grid_.y % worker_count_;
+  auto const slot_row = slot / grid_.x;
+  auto const long_rows = extra * (rows_per + 1U);
+
+  auto const worker = slot_row < long_rows ? slot_row / (rows_per + 1U)
+                                           : extra + (slot_row - long_rows) / rows_per;
+  auto const nth = slot_row < long_rows ? slot_row % (rows_per + 1U)
+                                        : (slot_row - long_rows) % rows_per;
+
+  return (nth * worker_count_ + worker) * grid_.x + slot % grid_.x;
+}
+
+auto Scheduler::pop_(n32 const worker) noexcept -> std::optional<n32> {
+  auto& range = deques_[worker].range;
+  auto cur = range.load(std::memory_order_relaxed);
+
+  for (;;) {
+    auto const [begin, end] = unpack(cur);
+
+    if (begin == end)
+      return std::nullopt;
+
+    if (range.compare_exchange_weak(cur, pack(begin + 1U, end), std::memory_order_relaxed))
+      return begin;
+  }
+}
+
+auto Scheduler::steal_(n32 const worker) noexcept -> std::optional<n32> {
+  // Only the owner ever refills a deque, and only once it is empty, so a range that was taken
+  // can never reappear and fool a compare-exchange
+  for (auto offset = 1U; offset < worker_count_; ++offset) {
+    auto& range = deques_[(worker + offset) % worker_count_].range;
+    auto cur = range.load(std::memory_order_relaxed);
+
+    for (;;) {
+      auto const [begin, end] = unpack(cur);
+
+      if (begin == end)
+        break;
+
+      auto const mid = end - (end - begin + 1U) / 2U;
+
+      if (range.compare_exchange_weak(cur, pack(begin, mid), std::memory_order_relaxed)) {
+        deques_[worker].range.store(pack(mid + 1U, end), std::memory_order_relaxed);
+        return mid;
+      }
+    }
+  }
+
+  return std::nullopt;
+}
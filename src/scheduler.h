@@ -0,0 +1,99 @@
+#pragma once
+
+#include "image.h"
+#include "util.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+// Splits a render into rectangular tiles and deals each worker a run of neighbouring ones, so
+// that its pixels and stores stay local. Workers that run dry steal half of someone else's
+// remaining tiles, taken from the far end of the run. Finished tiles are counted per row of
+// tiles, so that rows can be written out while the rest of the image renders. Given a ranking of
+// the tiles by cost, it deals them out costliest first instead, so that no expensive tile is left
+// for the end
+class Scheduler {
+public:
+  using Tile = Image::Rect;
+
+  // Wide enough for refill lanes to rarely run out of row, a few kilobytes of output each //
+  auto constexpr static tile_size = Image::Coord{128U, 8U};
+  // Square, so that subdivision has as little outline as possible to trace per pixel //
+  auto constexpr static subdivision_tile_size = Image::Coord{64U, 64U};
+
+  // Tiles area with tiles of the given size and splits them evenly between workers. in_order
+  // deals rows of tiles round-robin instead of in bands, so that the image fills in from the top
+  // rather than from the top of every band. ranking, if not empty, lists every tile index (row by
+  // row) costliest first and overrides in_order: tiles are then dealt round-robin one at a time,
+  // so that every worker starts on the costliest ones and thieves take the cheapest
+  auto reset(Image::Rect const& area, Image::Coord tile, n32 workers, bool in_order = false,
+             std::span<n32 const> ranking = {}) noexcept -> void;
+
+  using Deadline = std::chrono::steady_clock::time_point;
+
+  // Makes next() hand out nothing more once stop is requested or the deadline has passed, checked
+  // before every tile, for the renders that follow until it is lifted with limit({}, {})
+  auto limit(std::stop_token stop, std::optional<Deadline> deadline) noexcept -> void;
+
+  // Whether next() held back tiles because of the limit since the last reset() //
+  [[nodiscard]] auto cancelled() const noexcept {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+  // The worker's next tile, or nothing once no tiles are left anywhere //
+  [[nodiscard]] auto next(n32 worker) noexcept -> std::optional<Tile>;
+
+  // Marks a tile from next() as rendered. The locked decrement this takes also orders the
+  // streaming stores that rendered it before anything that sees the row finished
+  auto done(Tile const& tile) noexcept -> void;
+
+  // Whether every tile of row y of area has been rendered //
+  [[nodiscard]] auto rendered(n32 const y) const noexcept -> bool {
+    return pending_[(y - area_.lower.y) / tile_.y].load(std::memory_order_acquire) == 0U;
+  }
+
+  // Rows of tiles finished so far, which wait() sleeps on until it changes //
+  [[nodiscard]] auto progress() const noexcept { return finished_.load(std::memory_order_acquire); }
+  auto wait(n32 const progress) const noexcept -> void {
+    finished_.wait(progress, std::memory_order_acquire);
+  }
+
+private:
+  // Tile indices [begin, end) packed into one word, so that the owner taking from the front and
+  // thieves taking from the back settle any race with a single compare-exchange
+  struct alignas(64) Deque {
+    std::atomic<n64> range;
+  };
+
+  [[nodiscard]] auto pop_(n32 worker) noexcept -> std::optional<n32>;
+  [[nodiscard]] auto steal_(n32 worker) noexcept -> std::optional<n32>;
+
+  // The tile dealt to the given place in the deques //
+  [[nodiscard]] auto tile_index_(n32 slot) const noexcept -> n32;
+
+  Image::Rect area_ = {};
+  Image::Coord tile_ = {};
+  Image::Coord grid_ = {};
+
+  n32 worker_count_ = 0U;
+  bool in_order_ = false;
+  // The tile dealt to every slot, if dealt by ranking //
+  std::vector<n32> ranked_;
+  n32 capacity_ = 0U;
+  std::unique_ptr<Deque[]> deques_;
+
+  std::stop_token stop_;
+  std::optional<Deadline> deadline_;
+  bool limited_ = false;
+  std::atomic<bool> cancelled_ = false;
+
+  // Tiles yet to be rendered in every row of tiles //
+  n32 row_capacity_ = 0U;
+  std::unique_ptr<std::atomic<n32>[]> pending_;
+  std::atomic<n32> finished_ = 0U;
+};
@@ -0,0 +1,323 @@
+#include "server.h"
+#include "bigfloat.h"
+#include "complex.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fmt/core.h>
+#include <optional>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+template <typename T>
+[[nodiscard]] auto parse_number(std::string_view const str) -> std::optional<T> {
+  auto val = T{};
+  auto const [end, ec] = std::from_chars(str.data(), str.data() + str.size(), val);
+
+  if (ec != std::errc{} || end != str.data() + str.size())
+    return std::nullopt;
+
+  return val;
+}
+
+// The words of a line, as long as it has exactly count of them //
+template <Size count>
+[[nodiscard]] auto split(std::string_view line)
+    -> std::optional<std::array<std::string_view, count>> {
+  auto words = std::array<std::string_view, count>{};
+
+  for (auto& word : words) {
+    line.remove_prefix(std::min(line.find_first_not_of(' '), line.size()));
+    word = line.substr(0U, line.find(' '));
+    line.remove_prefix(word.size());
+
+    if (word.empty())
+      return std::nullopt;
+  }
+
+  if (line.find_first_not_of(' ') != std::string_view::npos)
+    return std::nullopt;
+
+  return words;
+}
+
+// The format and view of a request, on top of the server's settings //
+[[nodiscard]] auto parse_request(std::string_view const line, Image::Args args)
+    -> std::optional<std::pair<Format, Image::Args>> {
+  auto const words = split<7U>(line);
+  if (!words)
+    return std::nullopt;
+
+  auto const [name, xres, yres, maxiter, re, im, width] = *words;
+
+  auto const format = parse_format(name);
+  auto const x = parse_number<n32>(xres);
+  auto const y = parse_number<n32>(yres);
+  auto const iters = parse_number<n32>(maxiter);
+  auto const w = parse_number<f64>(width);
+
+  // As with -c, every decimal digit is worth a bit over 3 bits; the rest is headroom //
+  auto const limbs = BigFloat::limbs_for_bits(static_cast<n32>(4 * (re.size() + im.size())));
+  auto const re_big = BigFloat::parse(re, limbs);
+  auto const im_big = BigFloat::parse(im, limbs);
+
+  // Rows must be a whole number of the narrowest vectors //
+  if (!format || !x || !y || !iters || !w || !re_big || !im_big || *x == 0U || *y == 0U ||
+      *x % isa_width(Isa::Sse2) != 0U || *iters == 0U || !(*w > 0.0))
+    return std::nullopt;
+
+  auto const height = *w * static_cast<f64>(*y) / static_cast<f64>(*x);
+
+  args.resolution = {.x = *x, .y = *y};
+  args.maxiter = *iters;
+  args.color = is_color(*format);
+  args.center = Complex{*re_big, *im_big};
+  args.frame = {.lower = {-*w / 2.0, -height / 2.0}, .upper = {*w / 2.0, height / 2.0}};
+
+  return std::pair{*format, args};
+}
+
+} // namespace
+
+auto Server::serve_stream(int const in, int const out) noexcept -> bool {
+  clients_.assign(1U, {.in = in, .out = out, .pending = {}, .unsent = {}});
+
+  for (auto more = true; more;) {
+    more = read_(clients_.front());
+    answer_queued_();
+  }
+
+  return written_;
+}
+
+auto Server::serve_socket(std::string_view const path) noexcept -> bool {
+  auto addr = sockaddr_un{};
+  addr.sun_family = AF_UNIX;
+
+  if (path.size() >= sizeof(addr.sun_path))
+    return false;
+
+  std::ranges::copy(path, addr.sun_path);
+
+  // A socket left behind by an earlier server is replaced, but nothing else is //
+  struct stat st = {};
+  if (::lstat(addr.sun_path, &st) == 0 && S_ISSOCK(st.st_mode))
+    ::unlink(addr.sun_path);
+
+  auto const listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+  if (listener < 0)
+    return false;
+
+  if (::bind(listener, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(listener, SOMAXCONN) != 0) {
+    ::close(listener);
+    return false;
+  }
+
+  // A client hanging up before its answer is written must not take the server with it //
+  std::signal(SIGPIPE, SIG_IGN);
+
+  auto fds = std::vector<pollfd>{};
+
+  for (;;) {
+    // Clients are only read from once they have taken every answer, and written to once they
+    // can take more, so that one that stops reading holds up no other
+    fds.assign(1U, {.fd = listener, .events = POLLIN, .revents = 0});
+    for (auto const& client : clients_)
+      fds.push_back({.fd = client.in,
+                     .events = static_cast<short>(client.unsent.empty() ? POLLIN : POLLOUT),
+                     .revents = 0});
+
+    if (::poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+
+      ::close(listener);
+      return false;
+    }
+
+    // Every client that sent something in the meantime adds its requests to the same batch //
+    for (auto i = Size{}; i < clients_.size(); ++i) {
+      auto& client = clients_[i];
+
+      if (fds[i + 1U].revents == 0)
+        continue;
+
+      if (!client.unsent.empty())
+        flush_(client);
+      else if (!client.closing && !read_(client))
+        client.closing = true;
+    }
+
+    if ((fds.front().revents & POLLIN) != 0)
+      if (auto const fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+          fd >= 0)
+        clients_.push_back({.in = fd, .out = fd, .pending = {}, .unsent = {}});
+
+    answer_queued_();
+
+    std::erase_if(clients_, [](Client const& client) {
+      if (!client.closing || !client.unsent.empty())
+        return false;
+
+      ::close(client.in);
+      return true;
+    });
+  }
+}
+
+auto Server::read_(Client& client) noexcept -> bool {
+  auto buf = std::array<char, 4096>{};
+  auto const count = ::read(client.in, buf.data(), buf.size());
+
+  if (count < 0)
+    return errno == EINTR;
+
+  if (count == 0)
+    return false;
+
+  client.pending.append(buf.data(), static_cast<Size>(count));
+
+  auto start = Size{};
+  for (auto end = client.pending.find('\n'); end != std::string::npos;
+       end = client.pending.find('\n', start)) {
+    queue_(client.out, std::string_view{client.pending}.substr(start, end - start));
+    start = end + 1U;
+  }
+
+  client.pending.erase(0U, start);
+
+  if (client.pending.size() <= max_request_bytes)
+    return true;
+
+  queued_.push_back({.out = client.out,
+                     .line = {},
+                     .received = std::chrono::steady_clock::now(),
+                     .format = Format::Raw,
+                     .error = "malformed request"});
+  client.pending.clear();
+  return false;
+}
+
+auto Server::queue_(int const out, std::string_view line) noexcept -> void {
+  auto const received = std::chrono::steady_clock::now();
+
+  if (line.ends_with('\r'))
+    line.remove_suffix(1U);
+
+  auto const request = parse_request(line, base_);
+  auto const* const error =
+      !request ? "malformed request"
+               : Size{request->second.resolution.x} * request->second.resolution.y > max_pixels
+                     ? "too many pixels"
+                     : nullptr;
+
+  queued_.push_back({.out = out,
+                     .line = std::string{line},
+                     .received = received,
+                     .format = request ? request->first : Format::Raw,
+                     .error = error});
+
+  if (!error)
+    args_.push_back(request->second);
+}
+
+auto Server::answer_queued_() noexcept -> void {
+  if (images_.size() < args_.size())
+    images_.resize(args_.size());
+
+  if (!args_.empty())
+    renderer_.render_batch(args_, images_);
+
+  auto rendered = images_.begin();
+
+  for (auto const& request : queued_) {
+    if (request.error) {
+      auto const answer = fmt::format("error {}\n", request.error);
+      write_(request.out, answer.data(), answer.size());
+      continue;
+    }
+
+    auto const& image = *rendered++;
+    auto const& res = image.resolution();
+
+    char* data = nullptr;
+    auto size = Size{};
+    auto fp = ::open_memstream(&data, &size);
+
+    auto ok = fp != nullptr;
+    if (ok && is_png(request.format))
+      ok = renderer_.save_png(image, fp);
+    else if (ok)
+      ok = write_header(fp, request.format, res.x, res.y, image.maxiter()) &&
+           write_samples(fp, request.format, image.data(), Size{res.x} * res.y, res.x,
+                         image.maxiter());
+
+    ok = fp && std::fclose(fp) == 0 && ok;
+
+    auto const ready = std::chrono::steady_clock::now();
+    auto const ms = std::chrono::duration<f64, std::milli>{ready - request.received}.count();
+    auto const answer =
+        ok ? fmt::format("ok {} {:.3f}\n", size, ms) : std::string{"error failed to encode\n"};
+
+    write_(request.out, answer.data(), answer.size());
+    if (ok)
+      write_(request.out, data, size);
+
+    std::free(data);
+
+    auto const done = std::chrono::steady_clock::now();
+    fmt::print(stderr, "{}: {:.3f}ms ({:.3f}ms to write)\n", request.line,
+               std::chrono::duration<f64, std::milli>{done - request.received}.count(),
+               std::chrono::duration<f64, std::milli>{done - ready}.count());
+  }
+
+  queued_.clear();
+  args_.clear();
+}
+
+auto Server::write_(int const out, void const* const data, Size const size) noexcept -> void {
+  auto const client = std::ranges::find(clients_, out, &Client::out);
+
+  if (client == clients_.end() || client->broken)
+    return;
+
+  client->unsent.append(static_cast<char const*>(data), size);
+  flush_(*client);
+}
+
+auto Server::flush_(Client& client) noexcept -> void {
+  while (client.sent < client.unsent.size()) {
+    auto const count =
+        ::write(client.out, &client.unsent[client.sent], client.unsent.size() - client.sent);
+
+    if (count < 0 && errno == EINTR)
+      continue;
+
+    // The rest is written once poll() says the client takes more //
+    if (count < 0 && errno == EAGAIN)
+      return;
+
+    if (count <= 0) {
+      written_ = false;
+      client.closing = client.broken = true;
+      break;
+    }
+
+    client.sent += static_cast<Size>(count);
+  }
+
+  client.unsent.clear();
+  client.sent = 0U;
+}
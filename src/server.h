@@ -0,0 +1,92 @@
+#pragma once
+
+#include "image.h"
+#include "output.h"
+#include "renderer.h"
+#include "util.h"
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Answers render requests on one long-lived pool of workers, so that a stream of renders pays for
+// threads and buffers once rather than once each. A request is a line of text,
+//
+//   FORMAT XRES YRES MAXITER RE IM WIDTH
+//
+// naming a format as -f does and the view as -c and -w do; every other setting is the server's.
+// It is answered with a line "ok BYTES MS" followed by the image, BYTES long, MS being the
+// milliseconds from the request arriving to its image being ready, or with a line
+// "error MESSAGE". Requests that arrive together are rendered as a batch, see
+// Renderer::render_batch(), and answered in the order they arrived; MS thus covers the whole batch,
+// so a small request that shares one with a large one reports the large one's time
+class Server {
+public:
+  explicit Server(Image::Args const& base) noexcept : base_{base}, renderer_{base.thread_count} {}
+
+  // Serves the requests read from in, answering them on out, until in ends; returns whether every
+  // answer was written
+  auto serve_stream(int in, int out) noexcept -> bool;
+
+  // Listens on a Unix domain socket at path and serves every client that connects for as long as
+  // it stays connected; only returns if the socket cannot be set up
+  auto serve_socket(std::string_view path) noexcept -> bool;
+
+  // Requests for more pixels than this are turned down //
+  auto constexpr static max_pixels = Size{1U} << 26U;
+
+  // Clients that send this many bytes without ending a request are turned down and let go //
+  auto constexpr static max_request_bytes = Size{4096U};
+
+private:
+  struct Client {
+    int in, out;
+    // Bytes read that do not make a whole request yet //
+    std::string pending;
+    // Answers the client has yet to take, from sent on; nothing more is read from it until it has
+    // taken them all, so that it cannot queue up answers faster than it takes them
+    std::string unsent;
+    Size sent = 0U;
+    // Has nothing more to send; it is let go once its answers are out //
+    bool closing = false;
+    // Could not be written to, so takes no more answers //
+    bool broken = false;
+  };
+
+  struct Request {
+    int out;
+    std::string line;
+    std::chrono::steady_clock::time_point received;
+    Format format;
+    // Why the request is turned down, if it is //
+    char const* error;
+  };
+
+  // Reads what the client has sent and queues every whole request in it; returns false once it
+  // has nothing more to send, or has sent too long a request
+  auto read_(Client& client) noexcept -> bool;
+
+  // Queues a request, to be turned down in its turn if it does not parse //
+  auto queue_(int out, std::string_view line) noexcept -> void;
+
+  // Renders the queued requests as a batch and answers them //
+  auto answer_queued_() noexcept -> void;
+
+  // Queues data for the client that out belongs to and writes what it takes of it right away //
+  auto write_(int out, void const* data, Size size) noexcept -> void;
+
+  // Writes as much of the client's unsent answers as it takes without waiting for it //
+  auto flush_(Client& client) noexcept -> void;
+
+  Image::Args base_;
+  Renderer renderer_;
+  std::vector<Client> clients_;
+
+  std::vector<Request> queued_;
+  std::vector<Image::Args> args_;
+  // Kept from batch to batch, so that their buffers only grow when the requests do //
+  std::vector<Image> images_;
+
+  bool written_ = true;
+};
@@ -0,0 +1,690 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <fmt/ostream.h>
+#include <immintrin.h>
+#include <type_traits>
+
+#include "util.h"
+
+#define PS_COMP_TYPE OQ
+#define PS_COMP_HIDDEN2(a, b, op, type) _mm256_cmp_ps(a, b, _CMP_##op##_##type)
+#define PS_COMP_HIDDEN(a, b, op, type) PS_COMP_HIDDEN2(a, b, op, type)
+#define PS_COMP(a, b, op) PS_COMP_HIDDEN(a, b, op, PS_COMP_TYPE)
+
+#define PD_COMP_HIDDEN2(a, b, op, type) _mm256_cmp_pd(a, b, _CMP_##op##_##type)
+#define PD_COMP_HIDDEN(a, b, op, type) PD_COMP_HIDDEN2(a, b, op, type)
+#define PD_COMP(a, b, op) PD_COMP_HIDDEN(a, b, op, PS_COMP_TYPE)
+
+// 256-bit sets; lane masks are integer sets with every bit of a lane set or cleared //
+namespace simd::avx2 {
+
+union FloatSet;
+union DoubleSet;
+template <typename T> union IntSet;
+
+union FloatSet {
+  using Scalar = f32;
+  using Int = IntSet<n32>;
+  using Mask = IntSet<n32>;
+
+  static auto constexpr width = n32{8};
+
+  __m256 vec;
+  std::array<f32, width> lanes;
+
+  [[nodiscard]] constexpr FloatSet() noexcept {
+    if (std::is_constant_evaluated())
+      lanes = {};
+    else
+      vec = _mm256_setzero_ps();
+  }
+
+  [[nodiscard]] FloatSet(__m256 const& in) noexcept : vec{in} {}
+  [[nodiscard]] constexpr FloatSet(decltype(lanes) const& in) noexcept : lanes{in} {}
+  [[nodiscard]] constexpr FloatSet(f32 fill) noexcept {
+    if (std::is_constant_evaluated()) {
+      auto filled = decltype(lanes){};
+      filled.fill(fill);
+      lanes = filled;
+    } else
+      vec = _mm256_set1_ps(fill);
+  }
+
+  [[nodiscard]] auto operator+(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm256_add_ps(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator-(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm256_sub_ps(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator*(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm256_mul_ps(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator/(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm256_div_ps(vec, other.vec);
+  }
+
+  auto operator+=(FloatSet const& other) noexcept -> FloatSet& {
+    *this = *this + other;
+
+    return *this;
+  }
+
+  auto operator-=(FloatSet const& other) noexcept -> FloatSet& {
+    *this = *this - other;
+
+    return *this;
+  }
+
+  auto operator*=(FloatSet const& other) noexcept -> FloatSet& {
+    *this = *this * other;
+
+    return *this;
+  }
+
+  template <typename U> [[nodiscard]] auto operator^(U const& other) const noexcept -> FloatSet {
+    return _mm256_xor_ps(vec, *reinterpret_cast<__m256 const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator&(U const& other) const noexcept -> FloatSet {
+    return _mm256_and_ps(vec, *reinterpret_cast<__m256 const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator|(U const& other) const noexcept -> FloatSet {
+    return _mm256_or_ps(vec, *reinterpret_cast<__m256 const*>(&other.vec));
+  }
+
+  template <typename U> auto operator^=(U const& other) noexcept -> FloatSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator&=(U const& other) noexcept -> FloatSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator|=(U const& other) noexcept -> FloatSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] auto operator~() const noexcept -> FloatSet {
+    return _mm256_castsi256_ps(~_mm256_castps_si256(vec));
+  }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, FloatSet const& fset) -> std::ostream& {
+    os << "FloatSet: {";
+
+    for (std::size_t i = 0; i < fset.lanes.size(); ++i) {
+      os << fset.lanes[i];
+      if (i < fset.lanes.size() - 1)
+        os << ", ";
+    }
+
+    return os << '}';
+  }
+
+  constexpr explicit operator IntSet<i32>() const noexcept;
+
+  [[nodiscard]] auto movemask() const noexcept -> i32 { return _mm256_movemask_ps(vec); }
+
+  [[nodiscard]] static auto gather(f32 const* const base, IntSet<n32> const& idx) noexcept
+      -> FloatSet;
+
+  // Takes the lanes of other where the top bit of mask is set //
+  template <typename U>
+  [[nodiscard]] auto blend(FloatSet const& other, U const& mask) const noexcept -> FloatSet {
+    return _mm256_blendv_ps(vec, other.vec, *reinterpret_cast<__m256 const*>(&mask.vec));
+  }
+
+  auto store(void* const out) const noexcept -> void {
+    _mm256_store_ps(reinterpret_cast<float*>(out), vec);
+  }
+  auto store_unaligned(void* const out) const noexcept -> void {
+    _mm256_storeu_ps(reinterpret_cast<float*>(out), vec);
+  }
+  auto stream_store(void* const out) const noexcept -> void {
+    _mm256_stream_ps(reinterpret_cast<float*>(out), vec);
+  }
+};
+
+union DoubleSet {
+  using Scalar = f64;
+  using Int = IntSet<n64>;
+  using Mask = IntSet<n64>;
+
+  static auto constexpr width = n32{4};
+
+  __m256d vec;
+  std::array<f64, width> lanes;
+
+  [[nodiscard]] constexpr DoubleSet() noexcept {
+    if (std::is_constant_evaluated())
+      lanes = {};
+    else
+      vec = _mm256_setzero_pd();
+  }
+
+  [[nodiscard]] DoubleSet(__m256d const& in) noexcept : vec{in} {}
+  [[nodiscard]] constexpr DoubleSet(decltype(lanes) const& in) noexcept : lanes{in} {}
+  [[nodiscard]] constexpr DoubleSet(f64 fill) noexcept {
+    if (std::is_constant_evaluated()) {
+      auto filled = decltype(lanes){};
+      filled.fill(fill);
+      lanes = filled;
+    } else
+      vec = _mm256_set1_pd(fill);
+  }
+
+  [[nodiscard]] auto operator+(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm256_add_pd(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator-(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm256_sub_pd(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator*(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm256_mul_pd(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator/(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm256_div_pd(vec, other.vec);
+  }
+
+  auto operator+=(DoubleSet const& other) noexcept -> DoubleSet& {
+    *this = *this + other;
+
+    return *this;
+  }
+
+  auto operator-=(DoubleSet const& other) noexcept -> DoubleSet& {
+    *this = *this - other;
+
+    return *this;
+  }
+
+  auto operator*=(DoubleSet const& other) noexcept -> DoubleSet& {
+    *this = *this * other;
+
+    return *this;
+  }
+
+  template <typename U> [[nodiscard]] auto operator^(U const& other) const noexcept -> DoubleSet {
+    return _mm256_xor_pd(vec, *reinterpret_cast<__m256d const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator&(U const& other) const noexcept -> DoubleSet {
+    return _mm256_and_pd(vec, *reinterpret_cast<__m256d const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator|(U const& other) const noexcept -> DoubleSet {
+    return _mm256_or_pd(vec, *reinterpret_cast<__m256d const*>(&other.vec));
+  }
+
+  template <typename U> auto operator^=(U const& other) noexcept -> DoubleSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator&=(U const& other) noexcept -> DoubleSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator|=(U const& other) noexcept -> DoubleSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] auto operator~() const noexcept -> DoubleSet {
+    return _mm256_castsi256_pd(~_mm256_castpd_si256(vec));
+  }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, DoubleSet const& dset) -> std::ostream& {
+    os << "DoubleSet: {";
+
+    for (std::size_t i = 0; i < dset.lanes.size(); ++i) {
+      os << dset.lanes[i];
+      if (i < dset.lanes.size() - 1)
+        os << ", ";
+    }
+
+    return os << '}';
+  }
+
+  constexpr explicit operator IntSet<i64>() const noexcept;
+
+  [[nodiscard]] auto movemask() const noexcept -> i32 { return _mm256_movemask_pd(vec); }
+
+  [[nodiscard]] static auto gather(f64 const* const base, IntSet<n64> const& idx) noexcept
+      -> DoubleSet;
+
+  // Takes the lanes of other where the top bit of mask is set //
+  template <typename U>
+  [[nodiscard]] auto blend(DoubleSet const& other, U const& mask) const noexcept -> DoubleSet {
+    return _mm256_blendv_pd(vec, other.vec, *reinterpret_cast<__m256d const*>(&mask.vec));
+  }
+
+  auto store(void* const out) const noexcept -> void {
+    _mm256_store_pd(reinterpret_cast<double*>(out), vec);
+  }
+  auto store_unaligned(void* const out) const noexcept -> void {
+    _mm256_storeu_pd(reinterpret_cast<double*>(out), vec);
+  }
+  auto stream_store(void* const out) const noexcept -> void {
+    _mm256_stream_pd(reinterpret_cast<double*>(out), vec);
+  }
+};
+
+template <typename T> union IntSet {
+public:
+  using Scalar = T;
+  using Mask = IntSet;
+
+  static auto constexpr width = static_cast<n32>(sizeof(__m256i) / sizeof(T));
+
+  __m256i vec;
+  std::array<T, width> lanes;
+
+  [[nodiscard]] constexpr IntSet() noexcept {
+    if (std::is_constant_evaluated())
+      lanes = {};
+    else
+      vec = _mm256_setzero_si256();
+  }
+
+  [[nodiscard]] constexpr IntSet(__m256i const& in) noexcept : vec(in) {}
+  [[nodiscard]] constexpr IntSet(decltype(lanes) const& in) noexcept : lanes(in) {}
+
+  [[nodiscard]] constexpr IntSet(T fill) noexcept {
+    if (std::is_constant_evaluated()) {
+      auto filled = decltype(lanes){};
+      filled.fill(fill);
+      lanes = filled;
+    } else {
+      if constexpr (sizeof(T) == 8)
+        vec = _mm256_set1_epi64x(fill);
+      else if constexpr (sizeof(T) == 4)
+        vec = _mm256_set1_epi32(fill);
+      else if constexpr (sizeof(T) == 2)
+        vec = _mm256_set1_epi16(fill);
+      else if constexpr (sizeof(T) == 1)
+        vec = _mm256_set1_epi8(fill);
+      else
+        static_assert(always_false<T>, "Invalid size");
+    }
+  }
+
+  [[nodiscard]] auto operator+(IntSet const& other) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm256_add_epi64(vec, other.vec);
+    else if constexpr (sizeof(T) == 4)
+      return _mm256_add_epi32(vec, other.vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm256_add_epi16(vec, other.vec);
+    else if constexpr (sizeof(T) == 1)
+      return _mm256_add_epi8(vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  [[nodiscard]] auto operator-(IntSet const& other) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm256_sub_epi64(vec, other.vec);
+    else if constexpr (sizeof(T) == 4)
+      return _mm256_sub_epi32(vec, other.vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm256_sub_epi16(vec, other.vec);
+    else if constexpr (sizeof(T) == 1)
+      return _mm256_sub_epi8(vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  [[nodiscard]] auto operator*(IntSet const& other) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 4)
+      return _mm256_mullo_epi32(vec, other.vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm256_mullo_epi16(vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  auto operator+=(IntSet const& other) noexcept -> IntSet& {
+    *this = *this + other;
+
+    return *this;
+  }
+
+  auto operator-=(IntSet const& other) noexcept -> IntSet& {
+    *this = *this - other;
+
+    return *this;
+  }
+
+  auto operator*=(IntSet const& other) noexcept -> IntSet& {
+    *this = *this * other;
+
+    return *this;
+  }
+
+  template <typename U> [[nodiscard]] auto operator^(U const& other) const noexcept -> IntSet {
+    return _mm256_xor_si256(vec, *reinterpret_cast<__m256i const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator&(U const& other) const noexcept -> IntSet {
+    return _mm256_and_si256(vec, *reinterpret_cast<__m256i const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator|(U const& other) const noexcept -> IntSet {
+    return _mm256_or_si256(vec, *reinterpret_cast<__m256i const*>(&other.vec));
+  }
+
+  template <typename U> auto operator^=(U const& other) noexcept -> IntSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator&=(U const& other) noexcept -> IntSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator|=(U const& other) noexcept -> IntSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] auto operator~() const noexcept -> IntSet { return ~vec; }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, IntSet const& iset) -> std::ostream& {
+    os << "IntSet: {";
+
+    for (std::size_t i = 0; i < iset.lanes.size(); ++i) {
+      os << iset.lanes[i];
+      if (i < iset.lanes.size() - 1)
+        os << ", ";
+    }
+
+    return os << '}';
+  }
+
+  constexpr explicit operator FloatSet() const noexcept {
+    // TODO: Ensure it's signed //
+
+    if constexpr (sizeof(T) != 4)
+      static_assert(always_false<T>, "Invalid size for conversion");
+
+    if (std::is_constant_evaluated()) {
+      auto floats = decltype(FloatSet::lanes){};
+      std::copy(lanes.cbegin(), lanes.cend(), floats.begin());
+      return FloatSet{floats};
+    } else
+      return FloatSet{_mm256_cvtepi32_ps(vec)};
+  }
+
+  // Exact for 64-bit lanes of magnitude below 2^31. Narrowing leaves no arithmetic for -Ofast to
+  // reassociate with what follows, as it would a magic number's subtraction, rounding that off
+  explicit operator DoubleSet() const noexcept {
+    if constexpr (sizeof(T) != 8)
+      static_assert(always_false<T>, "Invalid size for conversion");
+
+    auto const low = _mm256_permutevar8x32_epi32(vec, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    return DoubleSet{_mm256_cvtepi32_pd(_mm256_castsi256_si128(low))};
+  }
+
+  [[nodiscard]] auto movemask() const noexcept -> i32 { return _mm256_movemask_epi8(vec); }
+
+  // One bit per lane of a mask, lowest lane first //
+  [[nodiscard]] auto bits() const noexcept -> n32 {
+    if constexpr (sizeof(T) == 8)
+      return static_cast<n32>(_mm256_movemask_pd(_mm256_castsi256_pd(vec)));
+    else if constexpr (sizeof(T) == 4)
+      return static_cast<n32>(_mm256_movemask_ps(_mm256_castsi256_ps(vec)));
+    else if constexpr (sizeof(T) == 1)
+      return static_cast<n32>(movemask());
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  [[nodiscard]] auto all() const noexcept -> bool { return movemask() == -1; }
+
+  // Inverse of bits() //
+  [[nodiscard]] static auto from_bits(n32 const bits) noexcept -> IntSet {
+    auto constexpr lane_bit = []() {
+      auto ret = IntSet{};
+      for (auto i = 0U; i < width; ++i)
+        ret.lanes[i] = static_cast<T>(T{1} << i);
+      return ret;
+    }();
+
+    return (IntSet{static_cast<T>(bits)} & lane_bit) == lane_bit;
+  }
+
+  // Lanes of base at the indices in idx //
+  [[nodiscard]] static auto gather(T const* const base, IntSet const& idx) noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm256_i64gather_epi64(reinterpret_cast<long long const*>(base), idx.vec, 8);
+    else if constexpr (sizeof(T) == 4)
+      return _mm256_i32gather_epi32(reinterpret_cast<int const*>(base), idx.vec, 4);
+    else
+      static_assert(always_false<T>, "Invalid size for gathering");
+  }
+
+  // For each lane, the number of lower lanes set in the mask //
+  [[nodiscard]] static auto rank(Mask const& mask) noexcept -> IntSet {
+    static auto constexpr table = []() {
+      auto ret = std::array<IntSet, 1U << width>{};
+      for (auto bits = 0U; bits < ret.size(); ++bits)
+        for (auto i = 0U; i < width; ++i)
+          ret[bits].lanes[i] = static_cast<T>(std::popcount(bits & ((1U << i) - 1U)));
+      return ret;
+    }();
+
+    return table[mask.bits()];
+  }
+
+  // Takes the lanes of other where mask is set; mask lanes must be all-ones or all-zeros //
+  template <typename U>
+  [[nodiscard]] auto blend(IntSet const& other, U const& mask) const noexcept -> IntSet {
+    return _mm256_blendv_epi8(vec, other.vec, *reinterpret_cast<__m256i const*>(&mask.vec));
+  }
+
+  [[nodiscard]] static auto load(void const* const in) noexcept -> IntSet {
+    return _mm256_load_si256(reinterpret_cast<decltype(vec) const*>(in));
+  }
+
+  [[nodiscard]] static auto load_unaligned(void const* const in) noexcept -> IntSet {
+    return _mm256_loadu_si256(reinterpret_cast<decltype(vec) const*>(in));
+  }
+
+  auto store(void* const out) const noexcept -> void {
+    _mm256_store_si256(reinterpret_cast<decltype(vec)*>(out), vec);
+  }
+
+  auto store_unaligned(void* const out) const noexcept -> void {
+    _mm256_storeu_si256(reinterpret_cast<decltype(vec)*>(out), vec);
+  }
+
+  auto stream_store(void* const out) const noexcept -> void {
+    _mm256_stream_si256(reinterpret_cast<decltype(vec)*>(out), vec);
+  }
+
+  // Stores the low 32 bits of each 64-bit lane contiguously; out must be 16-byte aligned //
+  auto stream_store_narrow(void* const out) const noexcept -> void {
+    if constexpr (sizeof(T) != 8)
+      static_assert(always_false<T>, "Invalid size for narrowing");
+
+    auto const packed = _mm256_permutevar8x32_epi32(vec, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(packed));
+  }
+};
+
+constexpr FloatSet::operator IntSet<i32>() const noexcept {
+  if (std::is_constant_evaluated()) {
+    auto ints = decltype(IntSet<i32>::lanes){};
+    std::copy(lanes.cbegin(), lanes.cend(), ints.begin());
+    return IntSet<i32>{ints};
+  } else
+    return IntSet<i32>{_mm256_cvttps_epi32(vec)};
+}
+
+inline auto FloatSet::gather(f32 const* const base, IntSet<n32> const& idx) noexcept -> FloatSet {
+  return _mm256_i32gather_ps(base, idx.vec, sizeof(f32));
+}
+
+inline auto DoubleSet::gather(f64 const* const base, IntSet<n64> const& idx) noexcept
+    -> DoubleSet {
+  return _mm256_i64gather_pd(base, idx.vec, sizeof(f64));
+}
+
+// Exact for lanes of magnitude below 2^51 //
+constexpr DoubleSet::operator IntSet<i64>() const noexcept {
+  if (std::is_constant_evaluated()) {
+    auto ints = decltype(IntSet<i64>::lanes){};
+    std::transform(lanes.cbegin(), lanes.cend(), ints.begin(),
+                   [](f64 lane) { return static_cast<i64>(lane); });
+    return IntSet<i64>{ints};
+  } else {
+    auto const magic = _mm256_set1_pd(0x1.8p52);
+    auto const shifted = _mm256_add_pd(_mm256_round_pd(vec, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC),
+                                       magic);
+    return IntSet<i64>{
+        _mm256_sub_epi64(_mm256_castpd_si256(shifted), _mm256_castpd_si256(magic))};
+  }
+}
+
+[[nodiscard]] inline auto operator==(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm256_castps_si256(PS_COMP(a.vec, b.vec, EQ));
+}
+
+[[nodiscard]] inline auto operator<(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm256_castps_si256(PS_COMP(a.vec, b.vec, LT));
+}
+
+[[nodiscard]] inline auto operator<=(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm256_castps_si256(PS_COMP(a.vec, b.vec, LE));
+}
+
+[[nodiscard]] inline auto operator!=(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm256_castps_si256(PS_COMP(a.vec, b.vec, NEQ));
+}
+
+[[nodiscard]] inline auto operator>(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm256_castps_si256(PS_COMP(a.vec, b.vec, GT));
+}
+
+[[nodiscard]] inline auto operator>=(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm256_castps_si256(PS_COMP(a.vec, b.vec, GE));
+}
+
+[[nodiscard]] inline auto operator==(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm256_castpd_si256(PD_COMP(a.vec, b.vec, EQ));
+}
+
+[[nodiscard]] inline auto operator<(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm256_castpd_si256(PD_COMP(a.vec, b.vec, LT));
+}
+
+[[nodiscard]] inline auto operator<=(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm256_castpd_si256(PD_COMP(a.vec, b.vec, LE));
+}
+
+[[nodiscard]] inline auto operator!=(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm256_castpd_si256(PD_COMP(a.vec, b.vec, NEQ));
+}
+
+[[nodiscard]] inline auto operator>(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm256_castpd_si256(PD_COMP(a.vec, b.vec, GT));
+}
+
+[[nodiscard]] inline auto operator>=(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm256_castpd_si256(PD_COMP(a.vec, b.vec, GE));
+}
+
+template <typename T>
+[[nodiscard]] auto operator==(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  if constexpr (sizeof(T) == 8)
+    return _mm256_cmpeq_epi64(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 4)
+    return _mm256_cmpeq_epi32(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 2)
+    return _mm256_cmpeq_epi16(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 1)
+    return _mm256_cmpeq_epi8(a.vec, b.vec);
+  else
+    static_assert(always_false<T>, "Invalid type size");
+}
+
+template <typename T>
+[[nodiscard]] auto operator!=(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  return ~(a == b);
+}
+
+template <typename T>
+[[nodiscard]] auto operator>(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  if constexpr (sizeof(T) == 8)
+    return _mm256_cmpgt_epi64(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 4)
+    return _mm256_cmpgt_epi32(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 2)
+    return _mm256_cmpgt_epi16(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 1)
+    return _mm256_cmpgt_epi8(a.vec, b.vec);
+  else
+    static_assert(always_false<T>, "Invalid type size");
+}
+
+template <typename T>
+[[nodiscard]] auto operator<(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  return b > a;
+}
+
+template <typename T>
+[[nodiscard]] auto operator<=(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  return ~(a > b);
+}
+
+template <typename T>
+[[nodiscard]] auto operator>=(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  return ~(b > a);
+}
+
+} // namespace simd::avx2
+
+#undef PS_COMP_TYPE
+#undef PS_COMP_HIDDEN2
+#undef PS_COMP_HIDDEN
+#undef PS_COMP
+#undef PD_COMP_HIDDEN2
+#undef PD_COMP_HIDDEN
+#undef PD_COMP
@@ -0,0 +1,764 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <fmt/ostream.h>
+#include <immintrin.h>
+#include <type_traits>
+
+#include "util.h"
+
+#define PS_COMP_TYPE OQ
+#define PS_COMP_HIDDEN2(a, b, op, type) _mm512_cmp_ps_mask(a, b, _CMP_##op##_##type)
+#define PS_COMP_HIDDEN(a, b, op, type) PS_COMP_HIDDEN2(a, b, op, type)
+#define PS_COMP(a, b, op) PS_COMP_HIDDEN(a, b, op, PS_COMP_TYPE)
+
+#define PD_COMP_HIDDEN2(a, b, op, type) _mm512_cmp_pd_mask(a, b, _CMP_##op##_##type)
+#define PD_COMP_HIDDEN(a, b, op, type) PD_COMP_HIDDEN2(a, b, op, type)
+#define PD_COMP(a, b, op) PD_COMP_HIDDEN(a, b, op, PS_COMP_TYPE)
+
+// 512-bit sets (AVX-512 F/DQ/BW/VL); comparisons produce one bit per lane in a mask register,
+// which blends and the arithmetic of the other sets consume directly
+namespace simd::avx512 {
+
+template <n32 width> struct MaskSet;
+union FloatSet;
+union DoubleSet;
+template <typename T> union IntSet;
+
+template <n32 lane_count> struct MaskSet {
+  using Bits = std::conditional_t<
+      lane_count <= 8, __mmask8,
+      std::conditional_t<lane_count <= 16, __mmask16,
+                         std::conditional_t<lane_count <= 32, __mmask32, __mmask64>>>;
+
+  static auto constexpr width = lane_count;
+  static auto constexpr full = static_cast<Bits>(~Bits{});
+
+  Bits vec = 0;
+
+  [[nodiscard]] constexpr MaskSet() noexcept = default;
+  [[nodiscard]] constexpr MaskSet(Bits in) noexcept : vec{in} {}
+
+  [[nodiscard]] constexpr auto operator^(MaskSet const& other) const noexcept -> MaskSet {
+    return static_cast<Bits>(vec ^ other.vec);
+  }
+
+  [[nodiscard]] constexpr auto operator&(MaskSet const& other) const noexcept -> MaskSet {
+    return static_cast<Bits>(vec & other.vec);
+  }
+
+  [[nodiscard]] constexpr auto operator|(MaskSet const& other) const noexcept -> MaskSet {
+    return static_cast<Bits>(vec | other.vec);
+  }
+
+  constexpr auto operator^=(MaskSet const& other) noexcept -> MaskSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  constexpr auto operator&=(MaskSet const& other) noexcept -> MaskSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  constexpr auto operator|=(MaskSet const& other) noexcept -> MaskSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] constexpr auto operator~() const noexcept -> MaskSet {
+    return static_cast<Bits>(~vec);
+  }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, MaskSet const& mset) -> std::ostream& {
+    return os << "MaskSet: {" << fmt::format("{:0{}b}", mset.vec, width) << '}';
+  }
+
+  // One bit per lane, lowest lane first //
+  [[nodiscard]] constexpr auto bits() const noexcept -> n32 {
+    static_assert(width <= 32, "Too many lanes for a 32-bit field");
+    return static_cast<n32>(vec);
+  }
+
+  [[nodiscard]] constexpr auto all() const noexcept -> bool { return vec == full; }
+
+  // Inverse of bits() //
+  [[nodiscard]] static constexpr auto from_bits(n32 const bits) noexcept -> MaskSet {
+    return static_cast<Bits>(bits);
+  }
+
+  // Takes the lanes of other where mask is set //
+  [[nodiscard]] constexpr auto blend(MaskSet const& other, MaskSet const& mask) const noexcept
+      -> MaskSet {
+    return (*this & ~mask) | (other & mask);
+  }
+};
+
+union FloatSet {
+  using Scalar = f32;
+  using Int = IntSet<n32>;
+  using Mask = MaskSet<16>;
+
+  static auto constexpr width = n32{16};
+
+  __m512 vec;
+  std::array<f32, width> lanes;
+
+  [[nodiscard]] constexpr FloatSet() noexcept {
+    if (std::is_constant_evaluated())
+      lanes = {};
+    else
+      vec = _mm512_setzero_ps();
+  }
+
+  [[nodiscard]] FloatSet(__m512 const& in) noexcept : vec{in} {}
+  [[nodiscard]] constexpr FloatSet(decltype(lanes) const& in) noexcept : lanes{in} {}
+  [[nodiscard]] constexpr FloatSet(f32 fill) noexcept {
+    if (std::is_constant_evaluated()) {
+      auto filled = decltype(lanes){};
+      filled.fill(fill);
+      lanes = filled;
+    } else
+      vec = _mm512_set1_ps(fill);
+  }
+
+  [[nodiscard]] auto operator+(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm512_add_ps(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator-(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm512_sub_ps(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator*(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm512_mul_ps(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator/(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm512_div_ps(vec, other.vec);
+  }
+
+  auto operator+=(FloatSet const& other) noexcept -> FloatSet& {
+    *this = *this + other;
+
+    return *this;
+  }
+
+  auto operator-=(FloatSet const& other) noexcept -> FloatSet& {
+    *this = *this - other;
+
+    return *this;
+  }
+
+  auto operator*=(FloatSet const& other) noexcept -> FloatSet& {
+    *this = *this * other;
+
+    return *this;
+  }
+
+  template <typename U> [[nodiscard]] auto operator^(U const& other) const noexcept -> FloatSet {
+    return _mm512_xor_ps(vec, *reinterpret_cast<__m512 const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator&(U const& other) const noexcept -> FloatSet {
+    return _mm512_and_ps(vec, *reinterpret_cast<__m512 const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator|(U const& other) const noexcept -> FloatSet {
+    return _mm512_or_ps(vec, *reinterpret_cast<__m512 const*>(&other.vec));
+  }
+
+  // Clears the lanes outside the mask //
+  [[nodiscard]] auto operator&(Mask const& mask) const noexcept -> FloatSet {
+    return _mm512_maskz_mov_ps(mask.vec, vec);
+  }
+
+  template <typename U> auto operator^=(U const& other) noexcept -> FloatSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator&=(U const& other) noexcept -> FloatSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator|=(U const& other) noexcept -> FloatSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] auto operator~() const noexcept -> FloatSet {
+    return _mm512_castsi512_ps(~_mm512_castps_si512(vec));
+  }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, FloatSet const& fset) -> std::ostream& {
+    os << "FloatSet: {";
+
+    for (std::size_t i = 0; i < fset.lanes.size(); ++i) {
+      os << fset.lanes[i];
+      if (i < fset.lanes.size() - 1)
+        os << ", ";
+    }
+
+    return os << '}';
+  }
+
+  constexpr explicit operator IntSet<i32>() const noexcept;
+
+  [[nodiscard]] auto movemask() const noexcept -> i32 {
+    return _mm512_movepi32_mask(_mm512_castps_si512(vec));
+  }
+
+  [[nodiscard]] static auto gather(f32 const* const base, IntSet<n32> const& idx) noexcept
+      -> FloatSet;
+
+  // Takes the lanes of other where mask is set //
+  [[nodiscard]] auto blend(FloatSet const& other, Mask const& mask) const noexcept -> FloatSet {
+    return _mm512_mask_blend_ps(mask.vec, vec, other.vec);
+  }
+
+  auto store(void* const out) const noexcept -> void {
+    _mm512_store_ps(reinterpret_cast<float*>(out), vec);
+  }
+  auto store_unaligned(void* const out) const noexcept -> void {
+    _mm512_storeu_ps(reinterpret_cast<float*>(out), vec);
+  }
+  auto stream_store(void* const out) const noexcept -> void {
+    _mm512_stream_ps(reinterpret_cast<float*>(out), vec);
+  }
+};
+
+union DoubleSet {
+  using Scalar = f64;
+  using Int = IntSet<n64>;
+  using Mask = MaskSet<8>;
+
+  static auto constexpr width = n32{8};
+
+  __m512d vec;
+  std::array<f64, width> lanes;
+
+  [[nodiscard]] constexpr DoubleSet() noexcept {
+    if (std::is_constant_evaluated())
+      lanes = {};
+    else
+      vec = _mm512_setzero_pd();
+  }
+
+  [[nodiscard]] DoubleSet(__m512d const& in) noexcept : vec{in} {}
+  [[nodiscard]] constexpr DoubleSet(decltype(lanes) const& in) noexcept : lanes{in} {}
+  [[nodiscard]] constexpr DoubleSet(f64 fill) noexcept {
+    if (std::is_constant_evaluated()) {
+      auto filled = decltype(lanes){};
+      filled.fill(fill);
+      lanes = filled;
+    } else
+      vec = _mm512_set1_pd(fill);
+  }
+
+  [[nodiscard]] auto operator+(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm512_add_pd(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator-(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm512_sub_pd(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator*(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm512_mul_pd(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator/(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm512_div_pd(vec, other.vec);
+  }
+
+  auto operator+=(DoubleSet const& other) noexcept -> DoubleSet& {
+    *this = *this + other;
+
+    return *this;
+  }
+
+  auto operator-=(DoubleSet const& other) noexcept -> DoubleSet& {
+    *this = *this - other;
+
+    return *this;
+  }
+
+  auto operator*=(DoubleSet const& other) noexcept -> DoubleSet& {
+    *this = *this * other;
+
+    return *this;
+  }
+
+  template <typename U> [[nodiscard]] auto operator^(U const& other) const noexcept -> DoubleSet {
+    return _mm512_xor_pd(vec, *reinterpret_cast<__m512d const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator&(U const& other) const noexcept -> DoubleSet {
+    return _mm512_and_pd(vec, *reinterpret_cast<__m512d const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator|(U const& other) const noexcept -> DoubleSet {
+    return _mm512_or_pd(vec, *reinterpret_cast<__m512d const*>(&other.vec));
+  }
+
+  // Clears the lanes outside the mask //
+  [[nodiscard]] auto operator&(Mask const& mask) const noexcept -> DoubleSet {
+    return _mm512_maskz_mov_pd(mask.vec, vec);
+  }
+
+  template <typename U> auto operator^=(U const& other) noexcept -> DoubleSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator&=(U const& other) noexcept -> DoubleSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator|=(U const& other) noexcept -> DoubleSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] auto operator~() const noexcept -> DoubleSet {
+    return _mm512_castsi512_pd(~_mm512_castpd_si512(vec));
+  }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, DoubleSet const& dset) -> std::ostream& {
+    os << "DoubleSet: {";
+
+    for (std::size_t i = 0; i < dset.lanes.size(); ++i) {
+      os << dset.lanes[i];
+      if (i < dset.lanes.size() - 1)
+        os << ", ";
+    }
+
+    return os << '}';
+  }
+
+  constexpr explicit operator IntSet<i64>() const noexcept;
+
+  [[nodiscard]] auto movemask() const noexcept -> i32 {
+    return _mm512_movepi64_mask(_mm512_castpd_si512(vec));
+  }
+
+  [[nodiscard]] static auto gather(f64 const* const base, IntSet<n64> const& idx) noexcept
+      -> DoubleSet;
+
+  // Takes the lanes of other where mask is set //
+  [[nodiscard]] auto blend(DoubleSet const& other, Mask const& mask) const noexcept -> DoubleSet {
+    return _mm512_mask_blend_pd(mask.vec, vec, other.vec);
+  }
+
+  auto store(void* const out) const noexcept -> void {
+    _mm512_store_pd(reinterpret_cast<double*>(out), vec);
+  }
+  auto store_unaligned(void* const out) const noexcept -> void {
+    _mm512_storeu_pd(reinterpret_cast<double*>(out), vec);
+  }
+  auto stream_store(void* const out) const noexcept -> void {
+    _mm512_stream_pd(reinterpret_cast<double*>(out), vec);
+  }
+};
+
+template <typename T> union IntSet {
+public:
+  using Scalar = T;
+
+  static auto constexpr width = static_cast<n32>(sizeof(__m512i) / sizeof(T));
+
+  using Mask = MaskSet<width>;
+
+  __m512i vec;
+  std::array<T, width> lanes;
+
+  [[nodiscard]] constexpr IntSet() noexcept {
+    if (std::is_constant_evaluated())
+      lanes = {};
+    else
+      vec = _mm512_setzero_si512();
+  }
+
+  [[nodiscard]] constexpr IntSet(__m512i const& in) noexcept : vec(in) {}
+  [[nodiscard]] constexpr IntSet(decltype(lanes) const& in) noexcept : lanes(in) {}
+
+  [[nodiscard]] constexpr IntSet(T fill) noexcept {
+    if (std::is_constant_evaluated()) {
+      auto filled = decltype(lanes){};
+      filled.fill(fill);
+      lanes = filled;
+    } else {
+      if constexpr (sizeof(T) == 8)
+        vec = _mm512_set1_epi64(static_cast<i64>(fill));
+      else if constexpr (sizeof(T) == 4)
+        vec = _mm512_set1_epi32(static_cast<i32>(fill));
+      else if constexpr (sizeof(T) == 2)
+        vec = _mm512_set1_epi16(static_cast<i16>(fill));
+      else if constexpr (sizeof(T) == 1)
+        vec = _mm512_set1_epi8(static_cast<i8>(fill));
+      else
+        static_assert(always_false<T>, "Invalid size");
+    }
+  }
+
+  [[nodiscard]] auto operator+(IntSet const& other) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm512_add_epi64(vec, other.vec);
+    else if constexpr (sizeof(T) == 4)
+      return _mm512_add_epi32(vec, other.vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm512_add_epi16(vec, other.vec);
+    else if constexpr (sizeof(T) == 1)
+      return _mm512_add_epi8(vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  [[nodiscard]] auto operator-(IntSet const& other) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm512_sub_epi64(vec, other.vec);
+    else if constexpr (sizeof(T) == 4)
+      return _mm512_sub_epi32(vec, other.vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm512_sub_epi16(vec, other.vec);
+    else if constexpr (sizeof(T) == 1)
+      return _mm512_sub_epi8(vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  [[nodiscard]] auto operator*(IntSet const& other) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm512_mullo_epi64(vec, other.vec);
+    else if constexpr (sizeof(T) == 4)
+      return _mm512_mullo_epi32(vec, other.vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm512_mullo_epi16(vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  auto operator+=(IntSet const& other) noexcept -> IntSet& {
+    *this = *this + other;
+
+    return *this;
+  }
+
+  auto operator-=(IntSet const& other) noexcept -> IntSet& {
+    *this = *this - other;
+
+    return *this;
+  }
+
+  auto operator*=(IntSet const& other) noexcept -> IntSet& {
+    *this = *this * other;
+
+    return *this;
+  }
+
+  template <typename U> [[nodiscard]] auto operator^(U const& other) const noexcept -> IntSet {
+    return _mm512_xor_si512(vec, *reinterpret_cast<__m512i const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator&(U const& other) const noexcept -> IntSet {
+    return _mm512_and_si512(vec, *reinterpret_cast<__m512i const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator|(U const& other) const noexcept -> IntSet {
+    return _mm512_or_si512(vec, *reinterpret_cast<__m512i const*>(&other.vec));
+  }
+
+  // Clears the lanes outside the mask //
+  [[nodiscard]] auto operator&(Mask const& mask) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm512_maskz_mov_epi64(mask.vec, vec);
+    else if constexpr (sizeof(T) == 4)
+      return _mm512_maskz_mov_epi32(mask.vec, vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm512_maskz_mov_epi16(mask.vec, vec);
+    else if constexpr (sizeof(T) == 1)
+      return _mm512_maskz_mov_epi8(mask.vec, vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  template <typename U> auto operator^=(U const& other) noexcept -> IntSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator&=(U const& other) noexcept -> IntSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator|=(U const& other) noexcept -> IntSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] auto operator~() const noexcept -> IntSet { return ~vec; }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, IntSet const& iset) -> std::ostream& {
+    os << "IntSet: {";
+
+    for (std::size_t i = 0; i < iset.lanes.size(); ++i) {
+      os << iset.lanes[i];
+      if (i < iset.lanes.size() - 1)
+        os << ", ";
+    }
+
+    return os << '}';
+  }
+
+  constexpr explicit operator FloatSet() const noexcept {
+    // TODO: Ensure it's signed //
+
+    if constexpr (sizeof(T) != 4)
+      static_assert(always_false<T>, "Invalid size for conversion");
+
+    if (std::is_constant_evaluated()) {
+      auto floats = decltype(FloatSet::lanes){};
+      std::copy(lanes.cbegin(), lanes.cend(), floats.begin());
+      return FloatSet{floats};
+    } else
+      return FloatSet{_mm512_cvtepi32_ps(vec)};
+  }
+
+  explicit operator DoubleSet() const noexcept {
+    if constexpr (sizeof(T) != 8)
+      static_assert(always_false<T>, "Invalid size for conversion");
+
+    return DoubleSet{_mm512_cvtepi64_pd(vec)};
+  }
+
+  // Lanes of base at the indices in idx //
+  [[nodiscard]] static auto gather(T const* const base, IntSet const& idx) noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm512_i64gather_epi64(idx.vec, base, 8);
+    else if constexpr (sizeof(T) == 4)
+      return _mm512_i32gather_epi32(idx.vec, base, 4);
+    else
+      static_assert(always_false<T>, "Invalid size for gathering");
+  }
+
+  // For each lane, the number of lower lanes set in the mask //
+  [[nodiscard]] static auto rank(Mask const& mask) noexcept -> IntSet {
+    // Expanding 0, 1, 2, ... hands the set lanes consecutive values in lane order //
+    if constexpr (sizeof(T) == 8)
+      return _mm512_maskz_expand_epi64(mask.vec, _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+    else if constexpr (sizeof(T) == 4)
+      return _mm512_maskz_expand_epi32(
+          mask.vec, _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  // Takes the lanes of other where mask is set //
+  [[nodiscard]] auto blend(IntSet const& other, Mask const& mask) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm512_mask_blend_epi64(mask.vec, vec, other.vec);
+    else if constexpr (sizeof(T) == 4)
+      return _mm512_mask_blend_epi32(mask.vec, vec, other.vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm512_mask_blend_epi16(mask.vec, vec, other.vec);
+    else if constexpr (sizeof(T) == 1)
+      return _mm512_mask_blend_epi8(mask.vec, vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  [[nodiscard]] static auto load(void const* const in) noexcept -> IntSet {
+    return _mm512_load_si512(in);
+  }
+
+  [[nodiscard]] static auto load_unaligned(void const* const in) noexcept -> IntSet {
+    return _mm512_loadu_si512(in);
+  }
+
+  auto store(void* const out) const noexcept -> void { _mm512_store_si512(out, vec); }
+
+  auto store_unaligned(void* const out) const noexcept -> void { _mm512_storeu_si512(out, vec); }
+
+  auto stream_store(void* const out) const noexcept -> void {
+    _mm512_stream_si512(reinterpret_cast<decltype(vec)*>(out), vec);
+  }
+
+  // Stores the low 32 bits of each 64-bit lane contiguously; out must be 32-byte aligned //
+  auto stream_store_narrow(void* const out) const noexcept -> void {
+    if constexpr (sizeof(T) != 8)
+      static_assert(always_false<T>, "Invalid size for narrowing");
+
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(out), _mm512_cvtepi64_epi32(vec));
+  }
+};
+
+constexpr FloatSet::operator IntSet<i32>() const noexcept {
+  if (std::is_constant_evaluated()) {
+    auto ints = decltype(IntSet<i32>::lanes){};
+    std::copy(lanes.cbegin(), lanes.cend(), ints.begin());
+    return IntSet<i32>{ints};
+  } else
+    return IntSet<i32>{_mm512_cvttps_epi32(vec)};
+}
+
+inline auto FloatSet::gather(f32 const* const base, IntSet<n32> const& idx) noexcept -> FloatSet {
+  return _mm512_i32gather_ps(idx.vec, base, sizeof(f32));
+}
+
+inline auto DoubleSet::gather(f64 const* const base, IntSet<n64> const& idx) noexcept
+    -> DoubleSet {
+  return _mm512_i64gather_pd(idx.vec, base, sizeof(f64));
+}
+
+constexpr DoubleSet::operator IntSet<i64>() const noexcept {
+  if (std::is_constant_evaluated()) {
+    auto ints = decltype(IntSet<i64>::lanes){};
+    std::transform(lanes.cbegin(), lanes.cend(), ints.begin(),
+                   [](f64 lane) { return static_cast<i64>(lane); });
+    return IntSet<i64>{ints};
+  } else
+    return IntSet<i64>{_mm512_cvttpd_epi64(vec)};
+}
+
+[[nodiscard]] inline auto operator==(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return PS_COMP(a.vec, b.vec, EQ);
+}
+
+[[nodiscard]] inline auto operator<(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return PS_COMP(a.vec, b.vec, LT);
+}
+
+[[nodiscard]] inline auto operator<=(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return PS_COMP(a.vec, b.vec, LE);
+}
+
+[[nodiscard]] inline auto operator!=(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return PS_COMP(a.vec, b.vec, NEQ);
+}
+
+[[nodiscard]] inline auto operator>(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return PS_COMP(a.vec, b.vec, GT);
+}
+
+[[nodiscard]] inline auto operator>=(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return PS_COMP(a.vec, b.vec, GE);
+}
+
+[[nodiscard]] inline auto operator==(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return PD_COMP(a.vec, b.vec, EQ);
+}
+
+[[nodiscard]] inline auto operator<(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return PD_COMP(a.vec, b.vec, LT);
+}
+
+[[nodiscard]] inline auto operator<=(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return PD_COMP(a.vec, b.vec, LE);
+}
+
+[[nodiscard]] inline auto operator!=(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return PD_COMP(a.vec, b.vec, NEQ);
+}
+
+[[nodiscard]] inline auto operator>(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return PD_COMP(a.vec, b.vec, GT);
+}
+
+[[nodiscard]] inline auto operator>=(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return PD_COMP(a.vec, b.vec, GE);
+}
+
+template <typename T>
+[[nodiscard]] auto operator==(IntSet<T> const& a, IntSet<T> const& b) noexcept ->
+    typename IntSet<T>::Mask {
+  if constexpr (sizeof(T) == 8)
+    return _mm512_cmpeq_epi64_mask(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 4)
+    return _mm512_cmpeq_epi32_mask(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 2)
+    return _mm512_cmpeq_epi16_mask(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 1)
+    return _mm512_cmpeq_epi8_mask(a.vec, b.vec);
+  else
+    static_assert(always_false<T>, "Invalid type size");
+}
+
+template <typename T>
+[[nodiscard]] auto operator!=(IntSet<T> const& a, IntSet<T> const& b) noexcept ->
+    typename IntSet<T>::Mask {
+  return ~(a == b);
+}
+
+// Signed, like the 256-bit and 128-bit sets //
+template <typename T>
+[[nodiscard]] auto operator>(IntSet<T> const& a, IntSet<T> const& b) noexcept ->
+    typename IntSet<T>::Mask {
+  if constexpr (sizeof(T) == 8)
+    return _mm512_cmpgt_epi64_mask(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 4)
+    return _mm512_cmpgt_epi32_mask(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 2)
+    return _mm512_cmpgt_epi16_mask(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 1)
+    return _mm512_cmpgt_epi8_mask(a.vec, b.vec);
+  else
+    static_assert(always_false<T>, "Invalid type size");
+}
+
+template <typename T>
+[[nodiscard]] auto operator<(IntSet<T> const& a, IntSet<T> const& b) noexcept ->
+    typename IntSet<T>::Mask {
+  return b > a;
+}
+
+template <typename T>
+[[nodiscard]] auto operator<=(IntSet<T> const& a, IntSet<T> const& b) noexcept ->
+    typename IntSet<T>::Mask {
+  return ~(a > b);
+}
+
+template <typename T>
+[[nodiscard]] auto operator>=(IntSet<T> const& a, IntSet<T> const& b) noexcept ->
+    typename IntSet<T>::Mask {
+  return ~(b > a);
+}
+
+} // namespace simd::avx512
+
+#undef PS_COMP_TYPE
+#undef PS_COMP_HIDDEN2
+#undef PS_COMP_HIDDEN
+#undef PS_COMP
+#undef PD_COMP_HIDDEN2
+#undef PD_COMP_HIDDEN
+#undef PD_COMP
@@ -0,0 +1,683 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <fmt/ostream.h>
+#include <immintrin.h>
+#include <type_traits>
+
+#include "util.h"
+
+// 128-bit sets for the x86-64 baseline; lane masks are integer sets with every bit of a lane set
+// or cleared. SSE2 lacks blends, gathers and 64-bit comparisons, so those are built from plainer
+// instructions
+namespace simd::sse2 {
+
+union FloatSet;
+union DoubleSet;
+template <typename T> union IntSet;
+
+union FloatSet {
+  using Scalar = f32;
+  using Int = IntSet<n32>;
+  using Mask = IntSet<n32>;
+
+  static auto constexpr width = n32{4};
+
+  __m128 vec;
+  std::array<f32, width> lanes;
+
+  [[nodiscard]] constexpr FloatSet() noexcept {
+    if (std::is_constant_evaluated())
+      lanes = {};
+    else
+      vec = _mm_setzero_ps();
+  }
+
+  [[nodiscard]] FloatSet(__m128 const& in) noexcept : vec{in} {}
+  [[nodiscard]] constexpr FloatSet(decltype(lanes) const& in) noexcept : lanes{in} {}
+  [[nodiscard]] constexpr FloatSet(f32 fill) noexcept {
+    if (std::is_constant_evaluated()) {
+      auto filled = decltype(lanes){};
+      filled.fill(fill);
+      lanes = filled;
+    } else
+      vec = _mm_set1_ps(fill);
+  }
+
+  [[nodiscard]] auto operator+(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm_add_ps(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator-(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm_sub_ps(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator*(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm_mul_ps(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator/(FloatSet const& other) const noexcept -> FloatSet {
+    return _mm_div_ps(vec, other.vec);
+  }
+
+  auto operator+=(FloatSet const& other) noexcept -> FloatSet& {
+    *this = *this + other;
+
+    return *this;
+  }
+
+  auto operator-=(FloatSet const& other) noexcept -> FloatSet& {
+    *this = *this - other;
+
+    return *this;
+  }
+
+  auto operator*=(FloatSet const& other) noexcept -> FloatSet& {
+    *this = *this * other;
+
+    return *this;
+  }
+
+  template <typename U> [[nodiscard]] auto operator^(U const& other) const noexcept -> FloatSet {
+    return _mm_xor_ps(vec, *reinterpret_cast<__m128 const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator&(U const& other) const noexcept -> FloatSet {
+    return _mm_and_ps(vec, *reinterpret_cast<__m128 const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator|(U const& other) const noexcept -> FloatSet {
+    return _mm_or_ps(vec, *reinterpret_cast<__m128 const*>(&other.vec));
+  }
+
+  template <typename U> auto operator^=(U const& other) noexcept -> FloatSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator&=(U const& other) noexcept -> FloatSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator|=(U const& other) noexcept -> FloatSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] auto operator~() const noexcept -> FloatSet {
+    return _mm_castsi128_ps(~_mm_castps_si128(vec));
+  }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, FloatSet const& fset) -> std::ostream& {
+    os << "FloatSet: {";
+
+    for (std::size_t i = 0; i < fset.lanes.size(); ++i) {
+      os << fset.lanes[i];
+      if (i < fset.lanes.size() - 1)
+        os << ", ";
+    }
+
+    return os << '}';
+  }
+
+  constexpr explicit operator IntSet<i32>() const noexcept;
+
+  [[nodiscard]] auto movemask() const noexcept -> i32 { return _mm_movemask_ps(vec); }
+
+  [[nodiscard]] static auto gather(f32 const* const base, IntSet<n32> const& idx) noexcept
+      -> FloatSet;
+
+  // Takes the lanes of other where mask is set; mask lanes must be all-ones or all-zeros //
+  template <typename U>
+  [[nodiscard]] auto blend(FloatSet const& other, U const& mask) const noexcept -> FloatSet {
+    auto const sel = *reinterpret_cast<__m128 const*>(&mask.vec);
+    return _mm_or_ps(_mm_andnot_ps(sel, vec), _mm_and_ps(sel, other.vec));
+  }
+
+  auto store(void* const out) const noexcept -> void {
+    _mm_store_ps(reinterpret_cast<float*>(out), vec);
+  }
+  auto store_unaligned(void* const out) const noexcept -> void {
+    _mm_storeu_ps(reinterpret_cast<float*>(out), vec);
+  }
+  auto stream_store(void* const out) const noexcept -> void {
+    _mm_stream_ps(reinterpret_cast<float*>(out), vec);
+  }
+};
+
+union DoubleSet {
+  using Scalar = f64;
+  using Int = IntSet<n64>;
+  using Mask = IntSet<n64>;
+
+  static auto constexpr width = n32{2};
+
+  __m128d vec;
+  std::array<f64, width> lanes;
+
+  [[nodiscard]] constexpr DoubleSet() noexcept {
+    if (std::is_constant_evaluated())
+      lanes = {};
+    else
+      vec = _mm_setzero_pd();
+  }
+
+  [[nodiscard]] DoubleSet(__m128d const& in) noexcept : vec{in} {}
+  [[nodiscard]] constexpr DoubleSet(decltype(lanes) const& in) noexcept : lanes{in} {}
+  [[nodiscard]] constexpr DoubleSet(f64 fill) noexcept {
+    if (std::is_constant_evaluated()) {
+      auto filled = decltype(lanes){};
+      filled.fill(fill);
+      lanes = filled;
+    } else
+      vec = _mm_set1_pd(fill);
+  }
+
+  [[nodiscard]] auto operator+(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm_add_pd(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator-(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm_sub_pd(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator*(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm_mul_pd(vec, other.vec);
+  }
+
+  [[nodiscard]] auto operator/(DoubleSet const& other) const noexcept -> DoubleSet {
+    return _mm_div_pd(vec, other.vec);
+  }
+
+  auto operator+=(DoubleSet const& other) noexcept -> DoubleSet& {
+    *this = *this + other;
+
+    return *this;
+  }
+
+  auto operator-=(DoubleSet const& other) noexcept -> DoubleSet& {
+    *this = *this - other;
+
+    return *this;
+  }
+
+  auto operator*=(DoubleSet const& other) noexcept -> DoubleSet& {
+    *this = *this * other;
+
+    return *this;
+  }
+
+  template <typename U> [[nodiscard]] auto operator^(U const& other) const noexcept -> DoubleSet {
+    return _mm_xor_pd(vec, *reinterpret_cast<__m128d const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator&(U const& other) const noexcept -> DoubleSet {
+    return _mm_and_pd(vec, *reinterpret_cast<__m128d const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator|(U const& other) const noexcept -> DoubleSet {
+    return _mm_or_pd(vec, *reinterpret_cast<__m128d const*>(&other.vec));
+  }
+
+  template <typename U> auto operator^=(U const& other) noexcept -> DoubleSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator&=(U const& other) noexcept -> DoubleSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator|=(U const& other) noexcept -> DoubleSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] auto operator~() const noexcept -> DoubleSet {
+    return _mm_castsi128_pd(~_mm_castpd_si128(vec));
+  }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, DoubleSet const& dset) -> std::ostream& {
+    os << "DoubleSet: {";
+
+    for (std::size_t i = 0; i < dset.lanes.size(); ++i) {
+      os << dset.lanes[i];
+      if (i < dset.lanes.size() - 1)
+        os << ", ";
+    }
+
+    return os << '}';
+  }
+
+  constexpr explicit operator IntSet<i64>() const noexcept;
+
+  [[nodiscard]] auto movemask() const noexcept -> i32 { return _mm_movemask_pd(vec); }
+
+  [[nodiscard]] static auto gather(f64 const* const base, IntSet<n64> const& idx) noexcept
+      -> DoubleSet;
+
+  // Takes the lanes of other where mask is set; mask lanes must be all-ones or all-zeros //
+  template <typename U>
+  [[nodiscard]] auto blend(DoubleSet const& other, U const& mask) const noexcept -> DoubleSet {
+    auto const sel = *reinterpret_cast<__m128d const*>(&mask.vec);
+    return _mm_or_pd(_mm_andnot_pd(sel, vec), _mm_and_pd(sel, other.vec));
+  }
+
+  auto store(void* const out) const noexcept -> void {
+    _mm_store_pd(reinterpret_cast<double*>(out), vec);
+  }
+  auto store_unaligned(void* const out) const noexcept -> void {
+    _mm_storeu_pd(reinterpret_cast<double*>(out), vec);
+  }
+  auto stream_store(void* const out) const noexcept -> void {
+    _mm_stream_pd(reinterpret_cast<double*>(out), vec);
+  }
+};
+
+template <typename T> union IntSet {
+public:
+  using Scalar = T;
+  using Mask = IntSet;
+
+  static auto constexpr width = static_cast<n32>(sizeof(__m128i) / sizeof(T));
+
+  __m128i vec;
+  std::array<T, width> lanes;
+
+  [[nodiscard]] constexpr IntSet() noexcept {
+    if (std::is_constant_evaluated())
+      lanes = {};
+    else
+      vec = _mm_setzero_si128();
+  }
+
+  [[nodiscard]] constexpr IntSet(__m128i const& in) noexcept : vec(in) {}
+  [[nodiscard]] constexpr IntSet(decltype(lanes) const& in) noexcept : lanes(in) {}
+
+  [[nodiscard]] constexpr IntSet(T fill) noexcept {
+    if (std::is_constant_evaluated()) {
+      auto filled = decltype(lanes){};
+      filled.fill(fill);
+      lanes = filled;
+    } else {
+      if constexpr (sizeof(T) == 8)
+        vec = _mm_set1_epi64x(static_cast<i64>(fill));
+      else if constexpr (sizeof(T) == 4)
+        vec = _mm_set1_epi32(static_cast<i32>(fill));
+      else if constexpr (sizeof(T) == 2)
+        vec = _mm_set1_epi16(static_cast<i16>(fill));
+      else if constexpr (sizeof(T) == 1)
+        vec = _mm_set1_epi8(static_cast<i8>(fill));
+      else
+        static_assert(always_false<T>, "Invalid size");
+    }
+  }
+
+  [[nodiscard]] auto operator+(IntSet const& other) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm_add_epi64(vec, other.vec);
+    else if constexpr (sizeof(T) == 4)
+      return _mm_add_epi32(vec, other.vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm_add_epi16(vec, other.vec);
+    else if constexpr (sizeof(T) == 1)
+      return _mm_add_epi8(vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  [[nodiscard]] auto operator-(IntSet const& other) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 8)
+      return _mm_sub_epi64(vec, other.vec);
+    else if constexpr (sizeof(T) == 4)
+      return _mm_sub_epi32(vec, other.vec);
+    else if constexpr (sizeof(T) == 2)
+      return _mm_sub_epi16(vec, other.vec);
+    else if constexpr (sizeof(T) == 1)
+      return _mm_sub_epi8(vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  [[nodiscard]] auto operator*(IntSet const& other) const noexcept -> IntSet {
+    if constexpr (sizeof(T) == 4) {
+      // Even and odd lanes are multiplied separately, then interleaved back //
+      auto const even = _mm_mul_epu32(vec, other.vec);
+      auto const odd = _mm_mul_epu32(_mm_srli_epi64(vec, 32), _mm_srli_epi64(other.vec, 32));
+      return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    } else if constexpr (sizeof(T) == 2)
+      return _mm_mullo_epi16(vec, other.vec);
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  auto operator+=(IntSet const& other) noexcept -> IntSet& {
+    *this = *this + other;
+
+    return *this;
+  }
+
+  auto operator-=(IntSet const& other) noexcept -> IntSet& {
+    *this = *this - other;
+
+    return *this;
+  }
+
+  auto operator*=(IntSet const& other) noexcept -> IntSet& {
+    *this = *this * other;
+
+    return *this;
+  }
+
+  template <typename U> [[nodiscard]] auto operator^(U const& other) const noexcept -> IntSet {
+    return _mm_xor_si128(vec, *reinterpret_cast<__m128i const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator&(U const& other) const noexcept -> IntSet {
+    return _mm_and_si128(vec, *reinterpret_cast<__m128i const*>(&other.vec));
+  }
+
+  template <typename U> [[nodiscard]] auto operator|(U const& other) const noexcept -> IntSet {
+    return _mm_or_si128(vec, *reinterpret_cast<__m128i const*>(&other.vec));
+  }
+
+  template <typename U> auto operator^=(U const& other) noexcept -> IntSet& {
+    *this = *this ^ other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator&=(U const& other) noexcept -> IntSet& {
+    *this = *this & other;
+
+    return *this;
+  }
+
+  template <typename U> auto operator|=(U const& other) noexcept -> IntSet& {
+    *this = *this | other;
+
+    return *this;
+  }
+
+  [[nodiscard]] auto operator~() const noexcept -> IntSet { return ~vec; }
+
+  [[nodiscard]] friend auto operator<<(std::ostream& os, IntSet const& iset) -> std::ostream& {
+    os << "IntSet: {";
+
+    for (std::size_t i = 0; i < iset.lanes.size(); ++i) {
+      os << iset.lanes[i];
+      if (i < iset.lanes.size() - 1)
+        os << ", ";
+    }
+
+    return os << '}';
+  }
+
+  constexpr explicit operator FloatSet() const noexcept {
+    // TODO: Ensure it's signed //
+
+    if constexpr (sizeof(T) != 4)
+      static_assert(always_false<T>, "Invalid size for conversion");
+
+    if (std::is_constant_evaluated()) {
+      auto floats = decltype(FloatSet::lanes){};
+      std::copy(lanes.cbegin(), lanes.cend(), floats.begin());
+      return FloatSet{floats};
+    } else
+      return FloatSet{_mm_cvtepi32_ps(vec)};
+  }
+
+  // Exact for 64-bit lanes of magnitude below 2^31. Narrowing leaves no arithmetic for -Ofast to
+  // reassociate with what follows, as it would a magic number's subtraction, rounding that off
+  explicit operator DoubleSet() const noexcept {
+    if constexpr (sizeof(T) != 8)
+      static_assert(always_false<T>, "Invalid size for conversion");
+
+    return DoubleSet{_mm_cvtepi32_pd(_mm_shuffle_epi32(vec, _MM_SHUFFLE(3, 1, 2, 0)))};
+  }
+
+  [[nodiscard]] auto movemask() const noexcept -> i32 { return _mm_movemask_epi8(vec); }
+
+  // One bit per lane of a mask, lowest lane first //
+  [[nodiscard]] auto bits() const noexcept -> n32 {
+    if constexpr (sizeof(T) == 8)
+      return static_cast<n32>(_mm_movemask_pd(_mm_castsi128_pd(vec)));
+    else if constexpr (sizeof(T) == 4)
+      return static_cast<n32>(_mm_movemask_ps(_mm_castsi128_ps(vec)));
+    else if constexpr (sizeof(T) == 1)
+      return static_cast<n32>(movemask());
+    else
+      static_assert(always_false<T>, "Invalid size");
+  }
+
+  [[nodiscard]] auto all() const noexcept -> bool { return movemask() == 0xFFFF; }
+
+  // Inverse of bits() //
+  [[nodiscard]] static auto from_bits(n32 const bits) noexcept -> IntSet {
+    auto constexpr lane_bit = []() {
+      auto ret = IntSet{};
+      for (auto i = 0U; i < width; ++i)
+        ret.lanes[i] = static_cast<T>(T{1} << i);
+      return ret;
+    }();
+
+    return (IntSet{static_cast<T>(bits)} & lane_bit) == lane_bit;
+  }
+
+  // Lanes of base at the indices in idx //
+  [[nodiscard]] static auto gather(T const* const base, IntSet const& idx) noexcept -> IntSet {
+    auto ret = IntSet{};
+    for (auto i = 0U; i < width; ++i)
+      ret.lanes[i] = base[idx.lanes[i]];
+    return ret;
+  }
+
+  // For each lane, the number of lower lanes set in the mask //
+  [[nodiscard]] static auto rank(Mask const& mask) noexcept -> IntSet {
+    static auto constexpr table = []() {
+      auto ret = std::array<IntSet, 1U << width>{};
+      for (auto bits = 0U; bits < ret.size(); ++bits)
+        for (auto i = 0U; i < width; ++i)
+          ret[bits].lanes[i] = static_cast<T>(std::popcount(bits & ((1U << i) - 1U)));
+      return ret;
+    }();
+
+    return table[mask.bits()];
+  }
+
+  // Takes the lanes of other where mask is set; mask lanes must be all-ones or all-zeros //
+  template <typename U>
+  [[nodiscard]] auto blend(IntSet const& other, U const& mask) const noexcept -> IntSet {
+    auto const sel = *reinterpret_cast<__m128i const*>(&mask.vec);
+    return _mm_or_si128(_mm_andnot_si128(sel, vec), _mm_and_si128(sel, other.vec));
+  }
+
+  [[nodiscard]] static auto load(void const* const in) noexcept -> IntSet {
+    return _mm_load_si128(reinterpret_cast<decltype(vec) const*>(in));
+  }
+
+  [[nodiscard]] static auto load_unaligned(void const* const in) noexcept -> IntSet {
+    return _mm_loadu_si128(reinterpret_cast<decltype(vec) const*>(in));
+  }
+
+  auto store(void* const out) const noexcept -> void {
+    _mm_store_si128(reinterpret_cast<decltype(vec)*>(out), vec);
+  }
+
+  auto store_unaligned(void* const out) const noexcept -> void {
+    _mm_storeu_si128(reinterpret_cast<decltype(vec)*>(out), vec);
+  }
+
+  auto stream_store(void* const out) const noexcept -> void {
+    _mm_stream_si128(reinterpret_cast<decltype(vec)*>(out), vec);
+  }
+
+  // Stores the low 32 bits of each 64-bit lane contiguously; out must be 8-byte aligned //
+  auto stream_store_narrow(void* const out) const noexcept -> void {
+    if constexpr (sizeof(T) != 8)
+      static_assert(always_false<T>, "Invalid size for narrowing");
+
+    auto const packed = _mm_shuffle_epi32(vec, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_stream_si64(reinterpret_cast<long long*>(out), _mm_cvtsi128_si64(packed));
+  }
+};
+
+constexpr FloatSet::operator IntSet<i32>() const noexcept {
+  if (std::is_constant_evaluated()) {
+    auto ints = decltype(IntSet<i32>::lanes){};
+    std::copy(lanes.cbegin(), lanes.cend(), ints.begin());
+    return IntSet<i32>{ints};
+  } else
+    return IntSet<i32>{_mm_cvttps_epi32(vec)};
+}
+
+inline auto FloatSet::gather(f32 const* const base, IntSet<n32> const& idx) noexcept -> FloatSet {
+  return _mm_setr_ps(base[idx.lanes[0]], base[idx.lanes[1]], base[idx.lanes[2]],
+                     base[idx.lanes[3]]);
+}
+
+inline auto DoubleSet::gather(f64 const* const base, IntSet<n64> const& idx) noexcept
+    -> DoubleSet {
+  return _mm_setr_pd(base[idx.lanes[0]], base[idx.lanes[1]]);
+}
+
+constexpr DoubleSet::operator IntSet<i64>() const noexcept {
+  if (std::is_constant_evaluated()) {
+    auto ints = decltype(IntSet<i64>::lanes){};
+    std::transform(lanes.cbegin(), lanes.cend(), ints.begin(),
+                   [](f64 lane) { return static_cast<i64>(lane); });
+    return IntSet<i64>{ints};
+  } else
+    return IntSet<i64>{_mm_set_epi64x(_mm_cvttsd_si64(_mm_unpackhi_pd(vec, vec)),
+                                      _mm_cvttsd_si64(vec))};
+}
+
+[[nodiscard]] inline auto operator==(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm_castps_si128(_mm_cmpeq_ps(a.vec, b.vec));
+}
+
+[[nodiscard]] inline auto operator<(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm_castps_si128(_mm_cmplt_ps(a.vec, b.vec));
+}
+
+[[nodiscard]] inline auto operator<=(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm_castps_si128(_mm_cmple_ps(a.vec, b.vec));
+}
+
+[[nodiscard]] inline auto operator!=(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  // Ordered, like the other comparisons: NaN lanes compare unequal to nothing //
+  return _mm_castps_si128(_mm_and_ps(_mm_cmpneq_ps(a.vec, b.vec), _mm_cmpord_ps(a.vec, b.vec)));
+}
+
+[[nodiscard]] inline auto operator>(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm_castps_si128(_mm_cmpgt_ps(a.vec, b.vec));
+}
+
+[[nodiscard]] inline auto operator>=(FloatSet const& a, FloatSet const& b) noexcept
+    -> FloatSet::Mask {
+  return _mm_castps_si128(_mm_cmpge_ps(a.vec, b.vec));
+}
+
+[[nodiscard]] inline auto operator==(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm_castpd_si128(_mm_cmpeq_pd(a.vec, b.vec));
+}
+
+[[nodiscard]] inline auto operator<(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm_castpd_si128(_mm_cmplt_pd(a.vec, b.vec));
+}
+
+[[nodiscard]] inline auto operator<=(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm_castpd_si128(_mm_cmple_pd(a.vec, b.vec));
+}
+
+[[nodiscard]] inline auto operator!=(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm_castpd_si128(_mm_and_pd(_mm_cmpneq_pd(a.vec, b.vec), _mm_cmpord_pd(a.vec, b.vec)));
+}
+
+[[nodiscard]] inline auto operator>(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm_castpd_si128(_mm_cmpgt_pd(a.vec, b.vec));
+}
+
+[[nodiscard]] inline auto operator>=(DoubleSet const& a, DoubleSet const& b) noexcept
+    -> DoubleSet::Mask {
+  return _mm_castpd_si128(_mm_cmpge_pd(a.vec, b.vec));
+}
+
+template <typename T>
+[[nodiscard]] auto operator==(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  if constexpr (sizeof(T) == 8) {
+    // Both halves of a lane have to match //
+    auto const halves = _mm_cmpeq_epi32(a.vec, b.vec);
+    return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+  } else if constexpr (sizeof(T) == 4)
+    return _mm_cmpeq_epi32(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 2)
+    return _mm_cmpeq_epi16(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 1)
+    return _mm_cmpeq_epi8(a.vec, b.vec);
+  else
+    static_assert(always_false<T>, "Invalid type size");
+}
+
+template <typename T>
+[[nodiscard]] auto operator!=(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  return ~(a == b);
+}
+
+template <typename T>
+[[nodiscard]] auto operator>(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  if constexpr (sizeof(T) == 8) {
+    // Signed high halves decide, unless they are equal and the unsigned low halves do //
+    auto const bias = _mm_set_epi32(0, i32{-0x7FFF'FFFF - 1}, 0, i32{-0x7FFF'FFFF - 1});
+    auto const gt = _mm_cmpgt_epi32(_mm_xor_si128(a.vec, bias), _mm_xor_si128(b.vec, bias));
+    auto const eq = _mm_cmpeq_epi32(a.vec, b.vec);
+    auto const high = _mm_or_si128(gt, _mm_and_si128(eq, _mm_slli_epi64(gt, 32)));
+    return _mm_shuffle_epi32(high, _MM_SHUFFLE(3, 3, 1, 1));
+  } else if constexpr (sizeof(T) == 4)
+    return _mm_cmpgt_epi32(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 2)
+    return _mm_cmpgt_epi16(a.vec, b.vec);
+  else if constexpr (sizeof(T) == 1)
+    return _mm_cmpgt_epi8(a.vec, b.vec);
+  else
+    static_assert(always_false<T>, "Invalid type size");
+}
+
+template <typename T>
+[[nodiscard]] auto operator<(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  return b > a;
+}
+
+template <typename T>
+[[nodiscard]] auto operator<=(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  return ~(a > b);
+}
+
+template <typename T>
+[[nodiscard]] auto operator>=(IntSet<T> const& a, IntSet<T> const& b) noexcept -> IntSet<T> {
+  return ~(b > a);
+}
+
+} // namespace simd::sse2
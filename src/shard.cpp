@@ -0,0 +1,101 @@
+#include "shard.h"
+#include "fingerprint.h"
+
+#include <array>
+#include <cinttypes>
+#include <cstring>
+#include <fmt/core.h>
+#include <string_view>
+
+namespace {
+
+auto constexpr magic = std::string_view{"mandelbrot-shard 1\n"};
+
+// Trailing zero limbs are left out, so that a centre given with more digits than it needs still
+// has the same fingerprint
+auto add_big(Fingerprint& hash, BigFloat const& val) noexcept -> void {
+  auto const limbs = val.limbs();
+  auto first = Size{};
+  while (first + 1U < limbs.size() && limbs[first] == 0U)
+    ++first;
+
+  for (auto i = first; i < limbs.size(); ++i)
+    hash.add(limbs[i]);
+  hash.add(static_cast<n32>(limbs.size() - first));
+}
+
+// Reads a line of the header into line, without its newline //
+[[nodiscard]] auto read_line(std::FILE* const fp, std::array<char, 64>& line) noexcept -> bool {
+  if (!std::fgets(line.data(), static_cast<int>(line.size()), fp))
+    return false;
+
+  auto const length = std::strlen(line.data());
+  if (length == 0U || line[length - 1U] != '\n')
+    return false;
+
+  line[length - 1U] = '\0';
+  return true;
+}
+
+} // namespace
+
+auto view_fingerprint(Image::Args const& args) noexcept -> n64 {
+  auto hash = Fingerprint{};
+
+  hash.add(args.resolution.x);
+  hash.add(args.resolution.y);
+  hash.add(args.frame.lower.x);
+  hash.add(args.frame.lower.y);
+  hash.add(args.frame.upper.x);
+  hash.add(args.frame.upper.y);
+  hash.add(args.maxiter);
+  hash.add(utype_cast(args.kernel));
+  hash.add(utype_cast(args.precision));
+  hash.add(args.subdivide);
+  hash.add(args.interior);
+  hash.add(args.center.has_value());
+
+  if (args.center) {
+    add_big(hash, args.center->real);
+    add_big(hash, args.center->imag);
+  }
+
+  return hash.value();
+}
+
+auto write_shard_header(std::FILE* const fp, ShardHeader const& header) noexcept -> bool {
+  fmt::print(fp, "{}size {} {}\nrows {} {}\nmaxiter {}\nview {:016x}\nisa {}\n\n", magic,
+             header.width, header.height, header.rows.begin, header.rows.end, header.maxiter,
+             header.view, isa_name(header.isa));
+  return std::ferror(fp) == 0;
+}
+
+auto read_shard_header(std::FILE* const fp) noexcept -> std::optional<ShardHeader> {
+  auto header = ShardHeader{};
+  auto line = std::array<char, 64>{};
+  auto isa = std::array<char, 16>{};
+
+  // Lines come in a fixed order, so that a mangled header is never half believed //
+  auto const ok =
+      read_line(fp, line) && magic.substr(0U, magic.size() - 1U) == line.data() &&
+      read_line(fp, line) &&
+      std::sscanf(line.data(), "size %u %u", &header.width, &header.height) == 2 &&
+      read_line(fp, line) &&
+      std::sscanf(line.data(), "rows %u %u", &header.rows.begin, &header.rows.end) == 2 &&
+      read_line(fp, line) && std::sscanf(line.data(), "maxiter %u", &header.maxiter) == 1 &&
+      read_line(fp, line) && std::sscanf(line.data(), "view %16" SCNx64, &header.view) == 1 &&
+      read_line(fp, line) && std::sscanf(line.data(), "isa %15s", isa.data()) == 1 &&
+      read_line(fp, line) && line[0] == '\0';
+
+  if (!ok)
+    return std::nullopt;
+
+  auto const parsed = parse_isa(isa.data());
+
+  if (!parsed || header.width == 0U || header.maxiter == 0U ||
+      header.rows.begin >= header.rows.end || header.rows.end > header.height)
+    return std::nullopt;
+
+  header.isa = *parsed;
+  return header;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "image.h"
+#include "isa.h"
+#include "util.h"
+
+#include <cstdio>
+#include <optional>
+
+// What a shard file holds: a band of rows of a frame, which may be rendered by several processes
+// or machines and merged into one image afterwards. The file is a short text header, ended by an
+// empty line, followed by the rows as native-endian n32 iteration counts, as Format::Raw has them
+struct ShardHeader {
+  // Of the whole frame //
+  n32 width, height;
+  Image::Band rows;
+  n32 maxiter;
+  // Fingerprint of everything that decides the pixels, see view_fingerprint() //
+  n64 view;
+  // Kernels that rendered the rows; those of other instruction sets may round differently //
+  Isa isa;
+
+  [[nodiscard]] auto pixel_count() const noexcept -> Size { return Size{rows.rows()} * width; }
+};
+
+// Tells apart the views whose pixels may differ: resolution, frame, centre, maxiter and the
+// choice of kernel, precision, subdivision and interior checking. Settings that only change how
+// fast the pixels are found, such as the thread count or prediction, are left out
+[[nodiscard]] auto view_fingerprint(Image::Args const& args) noexcept -> n64;
+
+auto write_shard_header(std::FILE* fp, ShardHeader const& header) noexcept -> bool;
+
+// Reads a header, leaving fp at the first sample; nothing is returned if it does not parse //
+[[nodiscard]] auto read_shard_header(std::FILE* fp) noexcept -> std::optional<ShardHeader>;
@@ -0,0 +1,71 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <fmt/core.h>
+
+namespace {
+
+// The counters as JSON members, indented by the given number of spaces //
+auto write_counters(std::FILE* const fp, WorkerStats const& stats, n32 const indent) noexcept
+    -> void {
+  auto const pad = fmt::format("{:{}}", "", indent);
+
+  fmt::print(fp, "{}\"tiles\": {},\n", pad, stats.tiles);
+  fmt::print(fp, "{}\"vectors\": {},\n", pad, stats.vectors);
+  fmt::print(fp, "{}\"lane_iterations\": {},\n", pad, stats.lane_iterations);
+  fmt::print(fp, "{}\"wasted_iterations\": {},\n", pad, stats.wasted_iterations);
+  fmt::print(fp, "{}\"cardioid_exits\": {},\n", pad, stats.cardioid_exits);
+  fmt::print(fp, "{}\"periodic_exits\": {},\n", pad, stats.periodic_exits);
+  fmt::print(fp, "{}\"wake_ms\": {:.3f},\n", pad, static_cast<f64>(stats.wake_ns) * 1e-6);
+  fmt::print(fp, "{}\"schedule_ms\": {:.3f},\n", pad, static_cast<f64>(stats.schedule_ns) * 1e-6);
+  fmt::print(fp, "{}\"busy_ms\": {:.3f},\n", pad, static_cast<f64>(stats.busy_ns) * 1e-6);
+  fmt::print(fp, "{}\"idle_ms\": {:.3f}", pad, static_cast<f64>(stats.idle_ns) * 1e-6);
+}
+
+} // namespace
+
+auto write_stats_json(std::FILE* const fp, std::span<WorkerStats const> const workers,
+                      n32 const lanes) noexcept -> void {
+  auto total = WorkerStats{};
+  auto max_busy = n64{};
+
+  for (auto const& w : workers) {
+    total.tiles += w.tiles;
+    total.vectors += w.vectors;
+    total.lane_iterations += w.lane_iterations;
+    total.wasted_iterations += w.wasted_iterations;
+    total.cardioid_exits += w.cardioid_exits;
+    total.periodic_exits += w.periodic_exits;
+    total.wake_ns += w.wake_ns;
+    total.schedule_ns += w.schedule_ns;
+    total.busy_ns += w.busy_ns;
+    total.idle_ns += w.idle_ns;
+    max_busy = std::max(max_busy, w.busy_ns);
+  }
+
+  // Lane steps that did useful work, and how close the workers came to all being busy as long as
+  // the busiest one
+  auto const simd_efficiency =
+      total.lane_iterations ? 1.0 - static_cast<f64>(total.wasted_iterations) /
+                                        static_cast<f64>(total.lane_iterations)
+                            : 1.0;
+  auto const load_balance =
+      max_busy ? static_cast<f64>(total.busy_ns) /
+                     (static_cast<f64>(max_busy) * static_cast<f64>(workers.size()))
+               : 1.0;
+
+  fmt::print(fp, "{{\n  \"threads\": {},\n  \"lanes\": {},\n", workers.size(), lanes);
+  fmt::print(fp, "  \"simd_efficiency\": {:.4f},\n", simd_efficiency);
+  fmt::print(fp, "  \"load_balance\": {:.4f},\n", load_balance);
+  fmt::print(fp, "  \"total\": {{\n");
+  write_counters(fp, total, 4U);
+  fmt::print(fp, "\n  }},\n  \"workers\": [\n");
+
+  for (auto i = Size{}; i < workers.size(); ++i) {
+    fmt::print(fp, "    {{\n");
+    write_counters(fp, workers[i], 6U);
+    fmt::print(fp, "\n    }}{}\n", i + 1U == workers.size() ? "" : ",");
+  }
+
+  fmt::print(fp, "  ]\n}}\n");
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <span>
+
+// What one worker did during a render. Every worker only ever touches its own, which sits on
+// cache lines of its own, so counting needs no atomics
+struct alignas(64) WorkerStats {
+  n64 tiles = 0U;
+  // Vectors of pixels started, or refills of some of their lanes with the refill kernel //
+  n64 vectors = 0U;
+  // Steps of every lane of every vector, and those that fell on lanes already done //
+  n64 lane_iterations = 0U;
+  n64 wasted_iterations = 0U;
+  // Pixels found in the main cardioid or period-2 bulb before iterating //
+  n64 cardioid_exits = 0U;
+  // Pixels retired as interior once their orbit was seen to repeat or be attracted //
+  n64 periodic_exits = 0U;
+
+  // From the render starting to the worker taking it up //
+  n64 wake_ns = 0U;
+  // Taking tiles off the scheduler, stealing included //
+  n64 schedule_ns = 0U;
+  // Rendering tiles //
+  n64 busy_ns = 0U;
+  // From running out of tiles to the last worker doing so //
+  n64 idle_ns = 0U;
+
+  // When the worker ran out of tiles in the current render //
+  std::chrono::steady_clock::time_point finished;
+};
+
+// Writes the counters of every worker and their totals as a JSON document; lanes is the width of
+// the vectors they were counted with
+auto write_stats_json(std::FILE* fp, std::span<WorkerStats const> workers, n32 lanes) noexcept
+    -> void;
@@ -0,0 +1,262 @@
+#include "tiles.h"
+#include "bigfloat.h"
+#include "complex.h"
+#include "fingerprint.h"
+#include "shard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fmt/core.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Strips of rows are encoded as PNG ones, so that every format is written a strip at a time //
+static_assert(tile_pixels % png_strip_rows == 0U);
+
+[[nodiscard]] auto address(TileAddress const first, n32 const cols, Size const index) noexcept {
+  return TileAddress{.level = first.level,
+                     .x = first.x + index % cols,
+                     .y = first.y + index / cols};
+}
+
+} // namespace
+
+auto tile_args(Image::Args const& base, TileAddress const tile) noexcept -> Image::Args {
+  auto const& frame = base.frame;
+  auto const width = frame.width();
+  auto const size = std::ldexp(width, -static_cast<i32>(tile.level));
+
+  auto const root = base.center.value_or(
+      Complex{BigFloat{(frame.lower.x + frame.upper.x) / 2.0, 2U},
+              BigFloat{(frame.lower.y + frame.upper.y) / 2.0, 2U}});
+
+  // The offsets of the tile's centre from the view's, in widths of the view, are exact in f64,
+  // and so are their products with the width given the bits of both
+  auto const scale = std::ldexp(1.0, -static_cast<i32>(tile.level));
+  auto const dx = (static_cast<f64>(tile.x) + 0.5) * scale - 0.5;
+  auto const dy = (static_cast<f64>(tile.y) + 0.5) * scale - 0.5;
+
+  auto const magnitude = static_cast<n32>(std::max(0.0, -std::log2(width)));
+  auto const limbs = std::max({BigFloat::limbs_for_bits(magnitude + tile.level + 128U),
+                               root.real.frac_limbs(), root.imag.frac_limbs()});
+  auto const big_width = BigFloat{width, limbs};
+
+  auto args = base;
+  args.resolution = {.x = tile_pixels, .y = tile_pixels};
+  args.center = Complex{root.real.with_limbs(limbs) + big_width * BigFloat{dx, limbs},
+                        root.imag.with_limbs(limbs) + big_width * BigFloat{dy, limbs}};
+  args.frame = {.lower = {-size / 2.0, -size / 2.0}, .upper = {size / 2.0, size / 2.0}};
+
+  return args;
+}
+
+auto tile_key(Image::Args const& args, TileAddress const tile) noexcept -> n64 {
+  auto hash = Fingerprint{};
+
+  hash.add(tile_cache_version);
+  hash.add(tile.level);
+  hash.add(tile.x);
+  hash.add(tile.y);
+  hash.add(view_fingerprint(args));
+  // Instruction sets round differently, with FMA or without, so their tiles must not be mixed //
+  hash.add(pick_isa(args));
+
+  return hash.value();
+}
+
+TileCache::TileCache(std::string_view const dir, Size const limit) noexcept
+    : dir_{dir}, limit_{limit} {
+  // Failing here shows as failing to store a tile //
+  auto ec = std::error_code{};
+  std::filesystem::create_directories(dir_, ec);
+}
+
+auto TileCache::touch(n64 const key) const noexcept -> bool {
+  auto const path = path_(key);
+  struct stat st = {};
+
+  // Anything but a whole tile is taken for none, and rendered again over it //
+  if (::stat(path.c_str(), &st) != 0 || static_cast<Size>(st.st_size) != tile_bytes())
+    return false;
+
+  return ::utimensat(AT_FDCWD, path.c_str(), nullptr, 0) == 0;
+}
+
+auto TileCache::find(n64 const key) const noexcept -> std::optional<MappedFile> {
+  auto file = MappedFile::open(path_(key));
+
+  if (!file || file->size() != tile_bytes())
+    return std::nullopt;
+
+  return file;
+}
+
+auto TileCache::store(n64 const key, n32 const* const pixels) const noexcept -> bool {
+  auto const path = path_(key);
+  auto const temp = fmt::format("{}.{}", path, ::getpid());
+
+  auto fp = std::fopen(temp.c_str(), "wb");
+
+  if (!fp)
+    return false;
+
+  auto ok = std::fwrite(pixels, 1U, tile_bytes(), fp) == tile_bytes();
+  ok = std::fclose(fp) == 0 && ok;
+
+  // Renaming replaces the tile in one go, even one another process is reading //
+  ok = ok && std::rename(temp.c_str(), path.c_str()) == 0;
+
+  if (!ok)
+    std::remove(temp.c_str());
+
+  return ok;
+}
+
+auto TileCache::trim() const noexcept -> void {
+  struct Entry {
+    std::filesystem::file_time_type used;
+    Size size;
+    std::filesystem::path path;
+  };
+
+  auto entries = std::vector<Entry>{};
+  auto total = Size{};
+  auto ec = std::error_code{};
+
+  for (auto const& file : std::filesystem::directory_iterator{dir_, ec}) {
+    if (file.path().extension() != ".tile")
+      continue;
+
+    auto const used = file.last_write_time(ec);
+    auto const size = file.file_size(ec);
+
+    // Tiles evicted by another process in the meantime are not counted //
+    if (ec)
+      continue;
+
+    entries.push_back({.used = used, .size = size, .path = file.path()});
+    total += size;
+  }
+
+  if (total <= limit_)
+    return;
+
+  std::ranges::sort(entries, {}, &Entry::used);
+
+  for (auto const& entry : entries) {
+    if (total <= limit_)
+      break;
+
+    std::filesystem::remove(entry.path, ec);
+    total -= entry.size;
+  }
+}
+
+auto TileCache::path_(n64 const key) const -> std::string {
+  return fmt::format("{}/{:016x}.tile", dir_, key);
+}
+
+auto write_tiles(Renderer& renderer, TileCache const& cache, Image::Args const& base,
+                 TileAddress const first, n32 const cols, n32 const rows, std::FILE* const fp,
+                 Format const format) noexcept -> std::optional<TileCounts> {
+  auto const count = Size{cols} * rows;
+  auto counts = TileCounts{};
+
+  auto keys = std::vector<n64>(count);
+  auto missing = std::vector<Image::Args>{};
+  auto missing_keys = std::vector<n64>{};
+
+  for (auto i = Size{}; i < count; ++i) {
+    auto const tile = address(first, cols, i);
+    auto args = tile_args(base, tile);
+    keys[i] = tile_key(args, tile);
+
+    if (cache.touch(keys[i])) {
+      ++counts.cached;
+      continue;
+    }
+
+    missing.push_back(std::move(args));
+    missing_keys.push_back(keys[i]);
+  }
+
+  // A few tiles per worker at a time, each rendered by one of them, bound the memory a request
+  // takes however many tiles it needs
+  auto const batch = std::min(Size{4U} * renderer.thread_count(), missing.size());
+  auto images = std::vector<Image>(batch);
+
+  for (auto begin = Size{}; begin < missing.size(); begin += batch) {
+    auto const end = std::min(begin + batch, missing.size());
+    renderer.render_batch(std::span{missing}.subspan(begin, end - begin), images);
+
+    for (auto i = begin; i < end; ++i)
+      if (!cache.store(missing_keys[i], images[i - begin].data()))
+        return std::nullopt;
+  }
+
+  counts.rendered = missing.size();
+  images.clear();
+
+  // The image is put together from the cache, a strip of rows of a row of tiles at a time //
+  auto const width = cols * tile_pixels;
+  auto const height = rows * tile_pixels;
+  auto const row_bytes = Size{tile_pixels} * sizeof(n32);
+
+  // PNG strips are filtered against the row above them, which is kept in front of the strip //
+  auto buffer = std::vector<n32>(Size{png_strip_rows + 1U} * width);
+  auto* const strip = &buffer[width];
+
+  auto strips = std::vector<PngStrip>{};
+  auto files = std::vector<MappedFile>{};
+  auto ok = format == Format::Png || write_header(fp, format, width, height, base.maxiter);
+
+  for (auto ty = 0U; ok && ty < rows; ++ty) {
+    files.clear();
+
+    for (auto tx = 0U; tx < cols; ++tx) {
+      auto file = cache.find(keys[Size{ty} * cols + tx]);
+      if (!file)
+        return std::nullopt;
+
+      files.push_back(std::move(*file));
+    }
+
+    for (auto y = 0U; ok && y < tile_pixels; y += png_strip_rows) {
+      for (auto row = 0U; row < png_strip_rows; ++row)
+        for (auto tx = 0U; tx < cols; ++tx)
+          std::memcpy(&strip[Size{row} * width + tx * tile_pixels],
+                      files[tx].data() + (y + row) * row_bytes, row_bytes);
+
+      auto const top = ty * tile_pixels + y;
+
+      if (format != Format::Png) {
+        ok = write_samples(fp, format, strip, Size{png_strip_rows} * width, width, base.maxiter);
+        continue;
+      }
+
+      auto const& encoded = strips.emplace_back(
+          encode_png_strip(strip, top == 0U ? nullptr : buffer.data(), width, png_strip_rows,
+                           base.maxiter, top + png_strip_rows == height));
+      ok = !encoded.data.empty();
+      std::copy_n(&strip[Size{png_strip_rows - 1U} * width], width, buffer.begin());
+    }
+  }
+
+  if (ok && format == Format::Png)
+    ok = write_png(fp, width, height, base.maxiter, strips);
+
+  cache.trim();
+
+  if (!ok)
+    return std::nullopt;
+
+  return counts;
+}
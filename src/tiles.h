@@ -0,0 +1,81 @@
+#pragma once
+
+#include "image.h"
+#include "mapped.h"
+#include "output.h"
+#include "renderer.h"
+#include "util.h"
+
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// A tile of the quadtree over a view, as map tile pyramids have them: level 0 is a single square
+// tile around the centre of the view and as wide as it, and every level splits each tile of the
+// one above into four. Tile (x, y) of a level is the x-th from the left and the y-th from the
+// bottom, rows of tiles running the way the rows of an image do
+struct TileAddress {
+  n32 level;
+  n64 x, y;
+};
+
+// Pixels along either side of a tile //
+auto constexpr inline tile_pixels = 256U;
+
+// Deepest level, down to which the centres of tiles are exact in f64 fractions of the view //
+auto constexpr inline max_tile_level = 48U;
+
+// Bumped whenever the kernels change what they compute, so that tiles cached before are not taken
+// for current ones
+auto constexpr inline tile_cache_version = 2U;
+
+// The view of a tile of the quadtree over base's view, with the rest of base's settings //
+[[nodiscard]] auto tile_args(Image::Args const& base, TileAddress tile) noexcept -> Image::Args;
+
+// Content hash naming a tile in a cache: its address, tile_cache_version, everything that decides
+// its pixels, see view_fingerprint(), of args, which tile_args() gave it, and the instruction set
+// it is rendered with, see pick_isa()
+[[nodiscard]] auto tile_key(Image::Args const& args, TileAddress tile) noexcept -> n64;
+
+// Finished tiles kept as files in a directory, named after their key and holding their pixels as
+// native-endian n32. Once they take more than the size limit, the least recently used ones are
+// evicted, a tile being used whenever it is stored or found. Processes may share a cache
+class TileCache {
+public:
+  TileCache(std::string_view dir, Size limit) noexcept;
+
+  // Whether the tile with this key is cached, marking it used if so //
+  [[nodiscard]] auto touch(n64 key) const noexcept -> bool;
+
+  // The pixels of the tile with this key, mapped into memory, if it is cached //
+  [[nodiscard]] auto find(n64 key) const noexcept -> std::optional<MappedFile>;
+
+  // Stores the pixels of a tile, whole or not at all, so that no process sees half of one //
+  auto store(n64 key, n32 const* pixels) const noexcept -> bool;
+
+  // Evicts tiles until the cache is within its limit //
+  auto trim() const noexcept -> void;
+
+  [[nodiscard]] auto constexpr static tile_bytes() noexcept {
+    return Size{tile_pixels} * tile_pixels * sizeof(n32);
+  }
+
+private:
+  [[nodiscard]] auto path_(n64 key) const -> std::string;
+
+  std::string dir_;
+  Size limit_;
+};
+
+struct TileCounts {
+  n64 cached = 0U;
+  n64 rendered = 0U;
+};
+
+// Writes the cols by rows tiles from first on to fp as a single image, taking those in cache from
+// it and rendering the others on renderer, a few per worker at a time, into it. Returns how many
+// tiles were found and rendered, or nothing if a tile could not be stored or written
+[[nodiscard]] auto write_tiles(Renderer& renderer, TileCache const& cache,
+                               Image::Args const& base, TileAddress first, n32 cols, n32 rows,
+                               std::FILE* fp, Format format) noexcept -> std::optional<TileCounts>;